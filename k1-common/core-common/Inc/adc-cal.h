@@ -0,0 +1,82 @@
+/// *****************************************************************************
+/// @file           : adc-cal.h
+/// @brief          : calibration of ADC readings by Vrefint and temperature
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// At boot the ADC runs its self-calibration, it removes the offset of the
+/// converter. Then the injected group of ADC1 converts Vrefint and the
+/// temperature sensor on every adc_cal_start(), between the regular scans.
+/// Vrefint gives the real VDDA, the gain VDDA / ADC_CAL_VDDA_MV brings all
+/// readings to the nominal full scale. The gain is computed once per
+/// injected conversion and given to adc-filter, so the correction of the
+/// values costs one multiplication and shift.
+/// STM32F103 has no factory calibration of Vrefint, the typical values of
+/// the datasheet are used.
+
+#ifndef INC_ADC_CAL_H_
+#define INC_ADC_CAL_H_
+
+#include "main.h"
+
+/// Vrefint, mV (typical, 1.16 - 1.24 V)
+#define ADC_CAL_VREFINT_MV      1200U
+/// nominal VDDA, mV, full scale of the corrected readings
+#define ADC_CAL_VDDA_MV         3300U
+/// temperature sensor at 25 C, mV (typical)
+#define ADC_CAL_TEMP_V25_MV     1430U
+/// temperature sensor slope, uV/C (typical)
+#define ADC_CAL_TEMP_SLOPE_UV   4300U
+/// IIR shift of Vrefint samples
+#define ADC_CAL_VREF_IIR_SHIFT  3U
+/// gain limits, Q14, VDDA out of them means a wrong Vrefint sample
+#define ADC_CAL_GAIN_MIN        ((uint16_t)(0.85 * 16384))
+#define ADC_CAL_GAIN_MAX        ((uint16_t)(1.15 * 16384))
+
+typedef enum
+{
+  ADC_CAL_OK,
+  ADC_CAL_ERR
+} ADC_CAL_ERR_CODES;
+
+/// counters of the calibration
+typedef struct
+{
+  uint32_t samples;       // injected conversions
+  uint32_t rejected;      // Vrefint samples out of the gain limits
+} adc_cal_stats_type;
+
+/// @name adc_cal_init
+/// @brief The function runs the self-calibration of ADC, it must be called
+/// @brief before the conversions are started.
+/// @param adc ADC with Vrefint on injected rank 1 and the temperature
+/// @param     sensor on injected rank 2, software start
+/// @return ADC_CAL_OK or ADC_CAL_ERR
+ADC_CAL_ERR_CODES adc_cal_init(ADC_HandleTypeDef * adc);
+
+/// @name adc_cal_start
+/// @brief The function starts the injected conversion of Vrefint and the
+/// @brief temperature sensor, it is called periodically.
+/// @return ADC_CAL_OK or ADC_CAL_ERR - ADC is busy
+ADC_CAL_ERR_CODES adc_cal_start(void);
+
+/// Injected conversion is complete, from ADC interrupt
+void adc_cal_isr(void);
+
+/// Get VDDA measured by Vrefint
+/// @return VDDA in mV, 0 - not measured yet
+uint16_t adc_cal_get_vdda_mv(void);
+
+/// Get the temperature of the MCU
+/// @return temperature in 0.1 C
+int16_t adc_cal_get_temp(void);
+
+/// Copy the counters of the calibration
+/// @param stats pointer to store the counters
+void adc_cal_get_stats(adc_cal_stats_type * stats);
+
+#endif // #ifndef INC_ADC_CAL_H_
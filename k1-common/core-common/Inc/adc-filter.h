@@ -0,0 +1,90 @@
+/// *****************************************************************************
+/// @file           : adc-filter.h
+/// @brief          : fixed-point oversampling and decimation of ADC channels
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// Every channel of the ADC scan passes 2 stages:
+/// - moving sum of 2^osr_log2 samples, decimated by the same ratio. The sum
+///   of 4^n samples with the ADC noise gives n extra bits of resolution;
+/// - first order IIR low-pass y += (x - y) >> iir_shift on the decimated
+///   values, iir_shift 0 bypasses it.
+/// Values are Q31 fractions of the ADC full scale (12 bit sample 4095 is
+/// almost 1.0), no floating point is used. The sum is taken per DMA block,
+/// so the ratio is at least ADC_SCAN_BLOCK_SCANS.
+/// The decimated values are corrected by the common gain of adc-cal, one
+/// multiplication and shift per value.
+
+#ifndef INC_ADC_FILTER_H_
+#define INC_ADC_FILTER_H_
+
+#include "main.h"
+#include "adc-scan.h"
+
+/// log2 of samples in DMA block, the minimal decimation
+#define ADC_FILTER_BLOCK_LOG2     3U
+/// maximal decimation, the sum of 12 bit samples stays in 24 bits
+#define ADC_FILTER_OSR_LOG2_MAX   12U
+/// maximal shift of IIR stage
+#define ADC_FILTER_IIR_SHIFT_MAX  15U
+/// gain correction, Q14
+#define ADC_FILTER_GAIN_SHIFT     14U
+#define ADC_FILTER_GAIN_ONE       (1U << ADC_FILTER_GAIN_SHIFT)
+
+#if (1U << ADC_FILTER_BLOCK_LOG2) != ADC_SCAN_BLOCK_SCANS
+#error "ADC_FILTER_BLOCK_LOG2 does not match ADC_SCAN_BLOCK_SCANS"
+#endif
+
+typedef enum
+{
+  ADC_FILTER_OK,
+  ADC_FILTER_ERR
+} ADC_FILTER_ERR_CODES;
+
+/// filter of the channel
+typedef struct
+{
+  uint8_t osr_log2;   // decimation 2^osr_log2 [ADC_FILTER_BLOCK_LOG2 - ADC_FILTER_OSR_LOG2_MAX]
+  uint8_t iir_shift;  // IIR time constant 2^iir_shift outputs, 0 - no IIR
+} adc_filter_config_type;
+
+/// @name adc_filter_init
+/// @brief The function sets the filters and resets their states.
+/// @param config filters of all channels, ADC_SCAN_CHANNELS items
+/// @return ADC_FILTER_OK or ADC_FILTER_ERR - wrong parameters
+ADC_FILTER_ERR_CODES adc_filter_init(const adc_filter_config_type * config);
+
+/// @name adc_filter_block
+/// @brief The function filters the block of samples, it is the handler of
+/// @brief adc_scan (DMA interrupt).
+/// @param block samples of all channels
+void adc_filter_block(const adc_scan_block_type * block);
+
+/// Set the gain correction of all channels, from the next decimated values
+/// @param gain_q14 gain, ADC_FILTER_GAIN_ONE - no correction
+void adc_filter_set_gain(uint16_t gain_q14);
+
+/// Get the gain correction
+/// @return gain, Q14
+uint16_t adc_filter_get_gain(void);
+
+/// Get the filtered value
+/// @param ch channel
+/// @return Q31 fraction of ADC full scale [0 - 0x7FFFFFFF]
+int32_t adc_filter_get_q31(adc_scan_channel_type ch);
+
+/// Get the filtered value
+/// @param ch channel
+/// @return Q15 fraction of ADC full scale [0 - 0x7FFF]
+int16_t adc_filter_get_q15(adc_scan_channel_type ch);
+
+/// Get the number of decimated values
+/// @param ch channel
+/// @return number of values (wraps), 0 - no value yet
+uint32_t adc_filter_get_outputs(adc_scan_channel_type ch);
+
+#endif // #ifndef INC_ADC_FILTER_H_
@@ -0,0 +1,99 @@
+/// *****************************************************************************
+/// @file           : adc-scan.h
+/// @brief          : timer triggered scan of ADC1 channels into DMA blocks
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// TIM3 update (TRGO) starts every ADC_SCAN_PERIOD_US a scan of all
+/// channels in the order of ADC_SCAN_CHANNELS, DMA1 channel 1 writes the
+/// results into a circular buffer of 2 blocks. The half and complete DMA
+/// events hand a block of ADC_SCAN_BLOCK_SCANS scans to the handler while
+/// DMA fills the other block, so the CPU sees only complete blocks.
+
+#ifndef INC_ADC_SCAN_H_
+#define INC_ADC_SCAN_H_
+
+#include "main.h"
+
+/// period of the scans, TIM3 period + 1 at 1 us tick
+#define ADC_SCAN_PERIOD_US     250U
+/// scans in one block
+#define ADC_SCAN_BLOCK_SCANS   8U
+
+/// channels of the scan, order of the ranks in MX_ADC1_Init()
+typedef enum
+{
+  ADC_SCAN_V_IN,        // ADC1_IN1 v_in_mon
+  ADC_SCAN_SECURITY1,   // ADC1_IN4
+  ADC_SCAN_SECURITY2,   // ADC1_IN5
+  ADC_SCAN_SECURITY3,   // ADC1_IN6
+  ADC_SCAN_SECURITY4,   // ADC1_IN7
+  ADC_SCAN_SECURITY5,   // ADC1_IN8
+  ADC_SCAN_SECURITY6,   // ADC1_IN9
+  ADC_SCAN_CHANNELS
+} adc_scan_channel_type;
+
+typedef enum
+{
+  ADC_SCAN_OK,
+  ADC_SCAN_ERR
+} ADC_SCAN_ERR_CODES;
+
+/// block of samples, 12 bit right aligned
+typedef struct
+{
+  uint16_t sample[ADC_SCAN_BLOCK_SCANS][ADC_SCAN_CHANNELS];
+} adc_scan_block_type;
+
+/// handler of the complete block, called from DMA interrupt, it must finish
+/// before DMA comes back to the block (ADC_SCAN_BLOCK_SCANS scans)
+/// @param block samples of the block
+typedef void (*adc_scan_handler_type)(const adc_scan_block_type * block);
+
+/// counters of the scan
+typedef struct
+{
+  uint32_t blocks;      // blocks handed to the handler
+  uint32_t errors;      // ADC or DMA errors
+} adc_scan_stats_type;
+
+/// @name adc_scan_init
+/// @brief The function starts DMA of ADC and its trigger timer.
+/// @param adc ADC in scan mode with external trigger, its DMA_Handle must
+/// @param     be linked to a circular DMA channel
+/// @param trigger timer with TRGO on update
+/// @return ADC_SCAN_OK or ADC_SCAN_ERR
+ADC_SCAN_ERR_CODES adc_scan_init(ADC_HandleTypeDef * adc, TIM_HandleTypeDef * trigger);
+
+/// Set the handler of complete blocks
+/// @param handler handler function or 0
+void adc_scan_set_handler(adc_scan_handler_type handler);
+
+/// Copy the counters of the scan
+/// @param stats pointer to store the counters
+void adc_scan_get_stats(adc_scan_stats_type * stats);
+
+/// Get ADC channel of the scan channel
+/// @param ch channel of the scan
+/// @return ADC_CHANNEL_x
+uint32_t adc_scan_get_adc_channel(adc_scan_channel_type ch);
+
+/// @name adc_scan_get_latest
+/// @brief The function reads the latest sample of the channel written by
+/// @brief DMA, it does not wait for the block.
+/// @param ch channel of the scan
+/// @return 12 bit sample
+uint16_t adc_scan_get_latest(adc_scan_channel_type ch);
+
+/// Block is complete, from ADC DMA interrupt
+/// @param half 1 - the first block (half transfer), 0 - the second one
+void adc_scan_block_isr(uint8_t half);
+
+/// ADC or DMA error, from interrupt
+void adc_scan_error_isr(void);
+
+#endif // #ifndef INC_ADC_SCAN_H_
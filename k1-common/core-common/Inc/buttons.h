@@ -14,12 +14,19 @@
 /// - Адресная линия K1
 /// - Кнопка адресации (внутри корпуса)
 
+/// The buttons are captured by EXTI on both edges. Buttons on the same pin
+/// share one physical pin: its edges are stamped once and debounced once.
+/// An edge calls the edge handler, the application runs buttons_handler()
+/// then and again after buttons_get_next_ms() while a button is moving or
+/// held for the long push. An idle device does no button work.
+
 #ifndef SRC_PERIPHERY_BUTTONS_H_
 #define SRC_PERIPHERY_BUTTONS_H_
 
 #include "stdint.h"
 #include "stddef.h"
 #include "main.h"
+#include "event-queue.h"
 
 // type to return fail codes of Buttons module
 typedef enum
@@ -32,11 +39,24 @@ typedef enum
 // supported modes for the button
 #define BUTTONS_MODE_SHORT_PUSH_EN  (0x1U << 0)
 #define BUTTONS_MODE_LONG_PUSH_EN   (0x1U << 1)
+#define BUTTONS_MODE_EDGES_EN       (0x1U << 2)   // debounced pushes and releases
 
 // timestamps for buttons counters
 #define BUTTONS_SHORT_PUSH_VAL_MS      60
 #define BUTTONS_LONG_PUSH_VAL_MS       1900
+// the pin is stable this time after the last edge
 #define BUTTONS_RELEASE_VAL_MS         30
+// size of the queue of the events, a power of 2
+#define BUTTONS_EVENTS_SIZE            16U
+
+/// events of the buttons, the argument is the number of the button
+enum
+{
+  BUTTONS_EV_SHORT_PUSH = 0,
+  BUTTONS_EV_LONG_PUSH,
+  BUTTONS_EV_PUSH,              // BUTTONS_MODE_EDGES_EN
+  BUTTONS_EV_RELEASE            // BUTTONS_MODE_EDGES_EN
+};
 
 /// buttons by functionality
 enum
@@ -66,18 +86,22 @@ typedef struct
   uint8_t MODE_FLAGS_SET;   // set of BUTTONS_MODE for the button
 }buttons_hw_type;
 
-// type to store Buttons work values
+// type to store work values of the physical pin
 typedef struct
 {
-  uint32_t push_counter;         // upward counts during pushing
-  uint32_t release_counter;      // upward counts during releasing
-  uint32_t short_push_flag  : 1; // button short pushing flag
-                                 // 1 - button was short pushed
-  uint32_t long_push_flag   : 1; // button long pushing flag
-                                 // 1 - button was long pushed
-  uint32_t release_flag     : 1; // button long pushing flag
-                                 // 1 - button was long pushed
-}buttons_vals_type;
+  GPIO_TypeDef* BASE;            // base address of the registers for the pin
+  uint16_t PIN;                  // pin number
+  uint32_t buttons;              // mask of the buttons on the pin
+  volatile uint64_t edge_us;     // the last edge, from EXTI interrupt
+  volatile uint8_t edges;        // counter of the edges, from EXTI interrupt
+  uint8_t edges_seen;            // edges counter of the last stable state
+  uint8_t pushed;                // debounced state, 1 - pushed
+  uint8_t long_sent;             // 1 - long pushing event of this push is sent
+  uint64_t push_us;              // debounced edge of the push
+}buttons_pin_type;
+
+/// handler of the button edges, called from EXTI interrupt
+typedef void (*buttons_edge_handler_type)(void);
 
 
 /// @name buttons_init
@@ -92,44 +116,38 @@ BUTTONS_FAIL_TYPE buttons_init();
 /// @author Aleksandr Shumilov
 /// created 03.06.2025
 /// @brief The function provides updating of buttons module data
-/// @brief For correct work period of the runtime should be less than 10 ms
+/// @brief It is called after the edge handler and after buttons_get_next_ms()
 /// @return BUTTONS_OK, BUTTONS_FAIL
 BUTTONS_FAIL_TYPE buttons_handler();
 
-/// @name buttons_get_short_push_flags
-/// @author Aleksandr Shumilov
-/// created 03.06.2025
-/// @brief The function returns flags for short pushing events
-/// @return Correspond bit is set to 1 if short pushing event is active for the
-/// @return button. Numbers of the bits correspond to
-/// @return         enum
-/// @return         {
-/// @return           BUTTON_FUNC_ADDR = 0,
-/// @return           BUTTON_FUNC_DUMMY1,
-/// @return           BUTTON_FUNC_DUMMY2,
-/// @return           BUTTON_FUNC_DUMMY3,
-/// @return           BUTTON_FUNC_DUMMY4,
-/// @return           BUTTONS_FUNC_AMOUNT
-/// @return         };
-uint32_t buttons_get_short_push_flags();
-
-
-/// @name buttons_get_long_push_flags
-/// @author Aleksandr Shumilov
-/// created 03.06.2025
-/// @brief The function returns flags for long pushing events
-/// @return Correspond bit is set to 1 if long pushing event is active for the
-/// @return button. Numbers of the bits correspond to
-/// @return         enum
-/// @return         {
-/// @return           BUTTON_FUNC_ADDR = 0,
-/// @return           BUTTON_FUNC_DUMMY1,
-/// @return           BUTTON_FUNC_DUMMY2,
-/// @return           BUTTON_FUNC_DUMMY3,
-/// @return           BUTTON_FUNC_DUMMY4,
-/// @return           BUTTONS_FUNC_AMOUNT
-/// @return         };
-uint32_t buttons_get_long_push_flags();
+/// @name buttons_get_next_ms
+/// @brief The function gives the time of the next update.
+/// @return time in ms till the next buttons_handler() call, 0 - the buttons
+/// @return are idle, the next edge calls the edge handler
+uint32_t buttons_get_next_ms(void);
+
+/// Set the handler of the button edges
+/// @param handler handler function or 0
+void buttons_set_edge_handler(buttons_edge_handler_type handler);
+
+/// @name buttons_exti_isr
+/// @brief The function stamps the edge of the pins, it is called from EXTI
+/// @brief interrupt.
+/// @param pin GPIO_PIN_x of the edge
+void buttons_exti_isr(uint16_t pin);
+
+/// @name buttons_get_event
+/// @brief The function takes the oldest event of the buttons. The events
+/// @brief are queued by buttons_handler(), none is lost between the calls.
+/// @param event pointer to store the event: type BUTTONS_EV_..., arg -
+/// @param       number of the button (BUTTON_FUNC_ADDR...), time_us - the
+/// @param       push edge, the release edge for BUTTONS_EV_RELEASE
+/// @return 1 - the event is taken, 0 - no events
+uint8_t buttons_get_event(event_queue_event_type * event);
+
+/// Copy the counters of the queue of the events
+/// @param stats pointer to store the counters
+void buttons_get_event_stats(event_queue_stats_type * stats);
 
 /// @name buttons_get_raw_state
 /// @author Aleksandr Shumilov
@@ -142,7 +160,6 @@ uint32_t buttons_get_long_push_flags();
 /// @param   BUTTON_FUNC_DUMMY1,
 /// @param   BUTTON_FUNC_DUMMY2,
 /// @param   BUTTON_FUNC_DUMMY3,
-/// @param   BUTTON_FUNC_DUMMY4,
 /// @param   BUTTONS_FUNC_AMOUNT
 /// @param };
 /// @return 1 - button is pushed, 0 - released
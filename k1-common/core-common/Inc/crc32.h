@@ -0,0 +1,87 @@
+/// *****************************************************************************
+/// @file           : crc32.h
+/// @brief          : shared CRC-32 service (CRC unit + software fallback)
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// CRC-32/MPEG-2: poly 0x04C11DB7, init 0xFFFFFFFF, no reflection, no final
+/// xor. This is the algorithm of the STM32F1 CRC unit, which takes 32-bit
+/// words and processes them MSB first.
+///
+/// Whole words go to the CRC unit. Bytes are packed into words MSB first, so
+/// a byte stream gets the same CRC as the bitwise algorithm; the last 1..3
+/// bytes of a stream are finished by a table-driven software CRC.
+///
+/// The unit has no initial value register on STM32F1, so only one stream can
+/// run in it. When a new stream begins, the running one takes the current
+/// value of the unit and continues in software. The service is used from the
+/// main loop only, not from interrupts; an interrupt runs its own stream by
+/// crc32_begin_sw(), it never touches the unit.
+
+#ifndef INC_CRC32_H_
+#define INC_CRC32_H_
+
+#include "main.h"
+
+#define CRC32_INIT_VAL    0xFFFFFFFFU
+
+/// context of CRC stream
+typedef struct
+{
+  uint32_t crc;       // CRC value when the stream runs in software
+  uint32_t tail;      // bytes waiting to complete a word, MSB first
+  uint8_t tail_len;   // number of bytes in the tail [0 - 3]
+  uint8_t in_unit;    // 1 - the stream runs in the CRC unit
+} crc32_ctx_type;
+
+/// @name crc32_init
+/// @brief The function initializes the service.
+/// @param crc_interface initialized CRC unit or 0 to use software only
+void crc32_init(CRC_HandleTypeDef * crc_interface);
+
+/// @name crc32_is_ready
+/// @return 1 - the service is initialized (with the CRC unit or software only)
+uint8_t crc32_is_ready(void);
+
+/// Start new CRC stream
+/// @param ctx context of the stream
+void crc32_begin(crc32_ctx_type * ctx);
+
+/// Start new CRC stream in software only, it may run in interrupts
+/// @param ctx context of the stream
+void crc32_begin_sw(crc32_ctx_type * ctx);
+
+/// Add 32-bit words to the stream
+/// @param ctx context of the stream
+/// @param words words, every word is processed MSB first
+/// @param num number of words
+void crc32_update_words(crc32_ctx_type * ctx, const uint32_t * words, uint32_t num);
+
+/// Add bytes to the stream
+/// @param ctx context of the stream
+/// @param bytes bytes, no alignment is required
+/// @param len number of bytes
+void crc32_update_bytes(crc32_ctx_type * ctx, const uint8_t * bytes, uint32_t len);
+
+/// Finish the stream
+/// @param ctx context of the stream
+/// @return CRC value
+uint32_t crc32_end(crc32_ctx_type * ctx);
+
+/// CRC of words, the same value as HAL_CRC_Calculate
+/// @param words words, every word is processed MSB first
+/// @param num number of words
+/// @return CRC value
+uint32_t crc32_calc_words(const uint32_t * words, uint32_t num);
+
+/// CRC of bytes
+/// @param bytes bytes, no alignment is required
+/// @param len number of bytes
+/// @return CRC value
+uint32_t crc32_calc_bytes(const uint8_t * bytes, uint32_t len);
+
+#endif // #ifndef INC_CRC32_H_
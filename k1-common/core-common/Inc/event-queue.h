@@ -0,0 +1,98 @@
+/// *****************************************************************************
+/// @file           : event-queue.h
+/// @brief          : lock-free queue of events between interrupts and tasks
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// The queue is a ring of typed events with one producer and one consumer.
+/// The producer writes only head, the consumer writes only tail, so neither
+/// side disables interrupts: the event is written to its slot before head
+/// is moved, the slot is read before tail is moved. The indices are 16 bit,
+/// their stores are atomic on Cortex-M3.
+/// The producer is an interrupt or a group of interrupts of the same NVIC
+/// priority (they do not preempt each other), the consumer is one task.
+/// A full queue drops the new event and counts it, the consumer finds the
+/// loss by the counters.
+/// The application gives the storage, the size is a power of 2.
+
+#ifndef INC_EVENT_QUEUE_H_
+#define INC_EVENT_QUEUE_H_
+
+#include "main.h"
+
+typedef enum
+{
+  EVENT_QUEUE_OK,
+  EVENT_QUEUE_ERR
+} EVENT_QUEUE_ERR_CODES;
+
+/// event
+typedef struct
+{
+  uint64_t time_us;             // timestamp, time_base_us() or the input edge
+  uint16_t type;                // type of the event, set by the application
+  uint16_t arg;                 // argument of the event
+} event_queue_event_type;
+
+/// queue, the fields are private for the module
+typedef struct
+{
+  event_queue_event_type * buf; // storage of the events
+  uint16_t mask;                // size - 1
+  volatile uint16_t head;       // next slot to write, the producer only
+  volatile uint16_t tail;       // next slot to read, the consumer only
+  volatile uint16_t max_used;   // the producer only
+  volatile uint32_t posted;     // the producer only
+  volatile uint32_t dropped;    // the producer only
+} event_queue_type;
+
+/// counters of the queue
+typedef struct
+{
+  uint32_t posted;              // events put into the queue
+  uint32_t dropped;             // events lost by the full queue
+  uint16_t max_used;            // the highest number of events in the queue
+} event_queue_stats_type;
+
+/// @name event_queue_init
+/// @brief The function sets the storage of the queue and empties it. It is
+/// @brief called before the producer starts.
+/// @param queue queue
+/// @param buf storage of the events, it must stay valid
+/// @param size number of the events in buf, a power of 2 [2 - 32768]
+/// @return EVENT_QUEUE_OK or EVENT_QUEUE_ERR - wrong size
+EVENT_QUEUE_ERR_CODES event_queue_init(event_queue_type * queue, event_queue_event_type * buf, uint16_t size);
+
+/// @name event_queue_post
+/// @brief The function puts the event into the queue, the producer side.
+/// @param queue queue
+/// @param type type of the event
+/// @param arg argument of the event
+/// @param time_us timestamp of the event
+/// @return EVENT_QUEUE_OK or EVENT_QUEUE_ERR - the queue is full, the event
+/// @return is dropped
+EVENT_QUEUE_ERR_CODES event_queue_post(event_queue_type * queue, uint16_t type, uint16_t arg, uint64_t time_us);
+
+/// @name event_queue_get
+/// @brief The function takes the oldest event from the queue, the consumer
+/// @brief side.
+/// @param queue queue
+/// @param event pointer to store the event
+/// @return 1 - the event is taken, 0 - the queue is empty
+uint8_t event_queue_get(event_queue_type * queue, event_queue_event_type * event);
+
+/// Get the number of the events in the queue
+/// @param queue queue
+/// @return number of the events
+uint16_t event_queue_count(const event_queue_type * queue);
+
+/// Copy the counters of the queue
+/// @param queue queue
+/// @param stats pointer to store the counters
+void event_queue_get_stats(const event_queue_type * queue, event_queue_stats_type * stats);
+
+#endif // #ifndef INC_EVENT_QUEUE_H_
@@ -0,0 +1,124 @@
+/// *****************************************************************************
+/// @file           : flash-async.h
+/// @brief          : background flash erase/program service on FLASH interrupt
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// Users of the flash (settings, event log, firmware staging) queue jobs:
+/// page erase, program of half-words with read-back verify, or verify only.
+/// The jobs run one after another, every flash operation is started by the
+/// end of operation (EOP) interrupt of the previous one, so no code spins
+/// on the BSY flag. The completion callback of a job is called from the
+/// FLASH interrupt, or from flash_async_poll() when the interrupt is masked
+/// (power fail path).
+/// STM32F103 has one flash bank: an instruction fetch from flash waits for
+/// the end of the operation. The service keeps the waits short and lets the
+/// interrupts be served between operations; an erase still stalls fetches
+/// for its whole time.
+/// An erase draws the largest current, on a weak supply the queue may be
+/// held before the next erase job by flash_async_hold_erase().
+
+#ifndef INC_FLASH_ASYNC_H_
+#define INC_FLASH_ASYNC_H_
+
+#include "main.h"
+
+/// number of queued jobs, power of 2
+#define FLASH_ASYNC_QUEUE_SIZE     4U
+/// priority of FLASH interrupt, below the K1 interrupts
+#define FLASH_ASYNC_IRQ_PRIORITY   3U
+
+typedef enum
+{
+  FLASH_ASYNC_OK,
+  FLASH_ASYNC_BUSY,         // the queue is full
+  FLASH_ASYNC_FLASH_ERR,    // erase or program error, verify mismatch
+  FLASH_ASYNC_ERR           // wrong parameters
+} FLASH_ASYNC_ERR_CODES;
+
+/// completion of the job
+/// @param res FLASH_ASYNC_OK or FLASH_ASYNC_FLASH_ERR
+/// @param ctx context given with the job
+typedef void (*flash_async_done_type)(FLASH_ASYNC_ERR_CODES res, void * ctx);
+
+/// counters of the service
+typedef struct
+{
+  uint32_t jobs;        // completed jobs
+  uint32_t erases;      // erased pages
+  uint32_t halfwords;   // programmed half-words
+  uint32_t flash_err;   // erase and program errors
+  uint32_t verify_err;  // read-back mismatches
+  uint32_t queue_full;  // jobs rejected
+  uint32_t erase_holds; // starts stopped at a held erase job
+} flash_async_stats_type;
+
+/// @name flash_async_init
+/// @brief The function resets the queue and enables FLASH interrupt.
+void flash_async_init(void);
+
+/// @name flash_async_erase
+/// @brief The function queues the erase of one page.
+/// @param addr address of the page
+/// @param done completion callback or 0
+/// @param ctx context for the callback
+/// @return FLASH_ASYNC_OK, FLASH_ASYNC_BUSY or FLASH_ASYNC_ERR
+FLASH_ASYNC_ERR_CODES flash_async_erase(uint32_t addr, flash_async_done_type done, void * ctx);
+
+/// @name flash_async_program
+/// @brief The function queues the program of half-words, every half-word
+/// @brief is read back and compared.
+/// @param addr flash address, aligned to 2
+/// @param data half-words to program, valid till the completion
+/// @param num number of half-words
+/// @param done completion callback or 0
+/// @param ctx context for the callback
+/// @return FLASH_ASYNC_OK, FLASH_ASYNC_BUSY or FLASH_ASYNC_ERR
+FLASH_ASYNC_ERR_CODES flash_async_program(uint32_t addr, const uint16_t * data, uint16_t num,
+                                          flash_async_done_type done, void * ctx);
+
+/// @name flash_async_verify
+/// @brief The function queues the compare of flash with data, after the
+/// @brief jobs queued before it.
+/// @param addr flash address, aligned to 2
+/// @param data half-words to compare, valid till the completion
+/// @param num number of half-words
+/// @param done completion callback or 0
+/// @param ctx context for the callback
+/// @return FLASH_ASYNC_OK, FLASH_ASYNC_BUSY or FLASH_ASYNC_ERR
+FLASH_ASYNC_ERR_CODES flash_async_verify(uint32_t addr, const uint16_t * data, uint16_t num,
+                                         flash_async_done_type done, void * ctx);
+
+/// Check the queue
+/// @return 1 - jobs are queued or running
+uint8_t flash_async_is_busy(void);
+
+/// @name flash_async_hold_erase
+/// @brief The function holds the queue before the next erase job or
+/// @brief releases it. The running operation is completed. Waiting loops
+/// @brief on the queue check flash_async_is_erase_held(), the queue does not
+/// @brief move while an erase job is held.
+/// @param hold 1 - hold, 0 - release
+void flash_async_hold_erase(uint8_t hold);
+
+/// Check the queue is stopped by the hold
+/// @return 1 - the next job is an erase and it is held
+uint8_t flash_async_is_erase_held(void);
+
+/// @name flash_async_poll
+/// @brief The function completes the operation without the interrupt, for
+/// @brief waiting loops which may run with interrupts disabled.
+void flash_async_poll(void);
+
+/// Copy the counters of the service
+/// @param stats pointer to store the counters
+void flash_async_get_stats(flash_async_stats_type * stats);
+
+/// FLASH interrupt, called after HAL_FLASH_IRQHandler()
+void flash_async_isr(void);
+
+#endif // #ifndef INC_FLASH_ASYNC_H_
@@ -0,0 +1,103 @@
+/// *****************************************************************************
+/// @file           : gesture.h
+/// @brief          : recognizer of button gestures
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// The recognizer takes BUTTONS_EV_PUSH and BUTTONS_EV_RELEASE of the buttons
+/// and matches them against const tables of gestures per button. A gesture
+/// is a sequence of elements: a click is a push shorter than hold_ms, a hold
+/// is a push of hold_ms or longer. Clicks of one sequence are apart by less
+/// than gap_ms. A hold ends the sequence, it is reported while the button is
+/// still pushed and may repeat every repeat_ms till the release.
+/// A sequence which no longer gesture starts with is reported at the last
+/// release, other sequences wait for gap_ms.
+/// Examples: {CLICK, CLICK} - double click, {CLICK, CLICK, CLICK} - triple
+/// click, {HOLD} with repeat_ms - press and hold with repeat, {CLICK, HOLD}
+/// - click and hold.
+/// The recognizer runs in the task of the buttons only, it needs
+/// gesture_handler() after gesture_get_next_ms() for the holds and the gaps.
+
+#ifndef INC_GESTURE_H_
+#define INC_GESTURE_H_
+
+#include "main.h"
+#include "buttons.h"
+#include "event-queue.h"
+
+/// maximal number of buttons with gestures
+#define GESTURE_INPUTS_MAX    BUTTONS_AMOUNT
+/// maximal number of elements in the gesture
+#define GESTURE_SEQ_MAX       4U
+/// size of the queue of the gestures, a power of 2
+#define GESTURE_EVENTS_SIZE   8U
+
+typedef enum
+{
+  GESTURE_OK,
+  GESTURE_ERR
+} GESTURE_ERR_CODES;
+
+/// elements of the gesture
+typedef enum
+{
+  GESTURE_END = 0,          // end of the sequence shorter than GESTURE_SEQ_MAX
+  GESTURE_CLICK,
+  GESTURE_HOLD              // the last element only
+} gesture_element_type;
+
+/// gesture
+typedef struct
+{
+  uint8_t seq[GESTURE_SEQ_MAX]; // elements, gesture_element_type
+  uint16_t repeat_ms;           // repeat of the hold while pushed, 0 - none
+  uint16_t id;                  // type of the reported event
+} gesture_type;
+
+/// gestures of the button
+typedef struct
+{
+  const gesture_type * gestures; // table of the gestures, 0 - no gestures
+  uint8_t gestures_num;
+  uint16_t hold_ms;             // a push of this time is a hold
+  uint16_t gap_ms;              // longest pause between clicks of a sequence
+} gesture_config_type;
+
+/// @name gesture_init
+/// @brief The function takes the tables of the gestures and resets the
+/// @brief recognizer.
+/// @param config gestures of the buttons by the number of the button, the
+/// @param        tables must stay valid
+/// @param num number of the buttons [0 - GESTURE_INPUTS_MAX]
+/// @return GESTURE_OK or GESTURE_ERR - wrong table
+GESTURE_ERR_CODES gesture_init(const gesture_config_type * config, uint8_t num);
+
+/// @name gesture_input
+/// @brief The function takes the event of the buttons, other than
+/// @brief BUTTONS_EV_PUSH and BUTTONS_EV_RELEASE are ignored.
+/// @param event event of buttons_get_event()
+void gesture_input(const event_queue_event_type * event);
+
+/// @name gesture_handler
+/// @brief The function completes the holds and the sequences after the gap.
+void gesture_handler(void);
+
+/// @name gesture_get_next_ms
+/// @brief The function gives the time of the next gesture_handler() call.
+/// @return time in ms, 0 - no gesture is in progress
+uint32_t gesture_get_next_ms(void);
+
+/// @name gesture_get
+/// @brief The function takes the oldest recognized gesture.
+/// @param event pointer to store the gesture: type - id of the gesture,
+/// @param       arg - number of the button in bits 0-7 and the repeat of
+/// @param       the hold in bits 8-15 (0 - the first report), time_us - the
+/// @param       first push of the sequence
+/// @return 1 - the gesture is taken, 0 - no gestures
+uint8_t gesture_get(event_queue_event_type * event);
+
+#endif // #ifndef INC_GESTURE_H_
@@ -19,8 +19,20 @@
 /// - Дублирующий адрес
 /// - Требуется обслуживание (по запыленности)
 /// - Режим ТЕСТ
+///
+/// Events of the item set and clear its conditions by ITEM_STATE_EVENTS
+/// (attention, fire, link lost, no address, duplicate, service, test), the
+/// state is the condition of the highest priority by ITEM_STATE_PRIORITY:
+/// FIRE, ATTENTION, NO_ADDRESS, DUPLICATE, LINK_LOST, TEST, SERVICE, NORM.
+/// An alarm hides the other conditions but keeps them, the reset of the
+/// alarm returns the item to them. FIRE is latched till the reset by the
+/// pult.
+/// Every transition is stamped by the microsecond time base. The event
+/// carries the time of its input edge, the time from the edge to the
+/// publication of the new state on K1 is the latency of the item.
 
 #include "main.h"
+#include "device-config.h"
 
 #ifndef INC_ITEM_STATE_H_
 #define INC_ITEM_STATE_H_
@@ -31,10 +43,68 @@ typedef enum
   ITEM_STATE_NORM,
   ITEM_STATE_ATTENTION,
   ITEM_STATE_FIRE,
-  ITEM_STATE_MAX = ITEM_STATE_FIRE
+  ITEM_STATE_LINK_LOST,       // no POLL from the pult
+  ITEM_STATE_NO_ADDRESS,      // address is not assigned
+  ITEM_STATE_DUPLICATE,       // duplicate address
+  ITEM_STATE_SERVICE,         // maintenance required (dust)
+  ITEM_STATE_TEST,
+  ITEM_STATE_MAX = ITEM_STATE_TEST
 } ITEM_STATE_TYPE;
 
-/// Set state for item
+/// events of the item
+typedef enum
+{
+  ITEM_EV_NORM,               // inputs are back to norm
+  ITEM_EV_ATTENTION,          // pre-alarm
+  ITEM_EV_FIRE,
+  ITEM_EV_RESET,              // reset of alarms by the pult
+  ITEM_EV_LINK_LOST,
+  ITEM_EV_LINK_OK,
+  ITEM_EV_ADDR_NONE,
+  ITEM_EV_ADDR_SET,
+  ITEM_EV_DUPLICATE,
+  ITEM_EV_SERVICE,            // dust, maintenance required
+  ITEM_EV_SERVICE_DONE,       // the detector is cleaned
+  ITEM_EV_TEST_ON,
+  ITEM_EV_TEST_OFF,
+  ITEM_EV_AMOUNT
+} ITEM_EVENT_TYPE;
+
+/// last transition of the item
+typedef struct
+{
+  ITEM_STATE_TYPE state;      // current state
+  ITEM_STATE_TYPE prev;       // state before the transition
+  ITEM_EVENT_TYPE event;      // event of the transition
+  uint64_t edge_us;           // input edge of the event
+  uint64_t change_us;         // time of the transition
+  uint64_t publish_us;        // publication on K1, 0 - not published yet
+} item_state_record_type;
+
+/// counters of the engine
+typedef struct
+{
+  uint32_t transitions;       // state changes
+  uint32_t ignored;           // events which do not change the state
+  uint32_t published;         // state changes published
+  uint32_t last_us;           // latency edge - publication of the last change
+  uint32_t max_us;            // worst latency
+} item_state_stats_type;
+
+/// @name item_state_init
+/// @brief The function sets all items to ITEM_STATE_UNDEFINED.
+void item_state_init(void);
+
+/// @name item_state_event
+/// @brief The function moves the item by the event.
+/// @param item item's number in the device [0 - K1_NUM_OF_ITEMS)
+/// @param event event of the item
+/// @param edge_us time of the input edge of the event, time_base_us()
+/// @return state of the item after the event
+ITEM_STATE_TYPE item_state_event(uint8_t item, ITEM_EVENT_TYPE event, uint64_t edge_us);
+
+/// Set state for item, the next event derives the state from the
+/// conditions again
 /// @param state state of the item, range ITEM_STATE_TYPE
 /// @param item item's number in the device [0 - K1_NUM_OF_ITEMS)
 void item_state_set(ITEM_STATE_TYPE state, uint8_t item);
@@ -44,6 +114,32 @@ void item_state_set(ITEM_STATE_TYPE state, uint8_t item);
 /// @return state of the item, range ITEM_STATE_TYPE
 ITEM_STATE_TYPE item_state_get(uint8_t item);
 
+/// Check the state is armed for K1
+/// @param item item's number in the device [0 - K1_NUM_OF_ITEMS)
+/// @return 1 - the state has changed since the reply was armed
+uint8_t item_state_is_changed(uint8_t item);
+
+/// Note the state is in the armed reply, the reply waits for the POLL
+/// @param item item's number in the device [0 - K1_NUM_OF_ITEMS)
+void item_state_armed(uint8_t item);
+
+/// @name item_state_published
+/// @brief The function notes the start of the armed reply on K1 and
+/// @brief counts the latency of the change: from the input edge through
+/// @brief the wait for the POLL to the reply on the line.
+/// @param item item's number in the device [0 - K1_NUM_OF_ITEMS)
+/// @param publish_us start of the reply, k1_tx_get_started()
+void item_state_published(uint8_t item, uint64_t publish_us);
+
+/// Copy the last transition of the item
+/// @param item item's number in the device [0 - K1_NUM_OF_ITEMS)
+/// @param record pointer to store the transition
+void item_state_get_record(uint8_t item, item_state_record_type * record);
+
+/// Copy the counters of the engine
+/// @param stats pointer to store the counters
+void item_state_get_stats(item_state_stats_type * stats);
+
 
 
 #endif /* INC_ITEM_STATE_H_ */
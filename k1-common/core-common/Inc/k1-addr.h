@@ -15,6 +15,11 @@
 /// - Встроенный UID
 /// - Контроль дублирующего адреса
 
+/// Besides the addresses by item the module keeps a 256-bit map of the own
+/// addresses and the reverse table address -> item. k1_addr_set() updates
+/// them, so the receive interrupt checks a frame by one bit test and finds
+/// the item by one table load for any K1_NUM_OF_ITEMS.
+
 #include "main.h"
 
 #ifndef INC_K1_ADDR_H_
@@ -25,10 +30,14 @@ typedef enum
 	K1_ADDR_ERR
 }K1_ADDR_ERR_CODES;
 
+/// no item has the address
+#define K1_ADDR_NO_ITEM 0xFFU
+
 /// Set address for item
 /// @param addr address of the item, range [1 - 255]
 /// @param item item's number in the device [0 - K1_NUM_OF_ITEMS)
 /// @return K1_ADDR_OK when addrss added, K1_ADDR_ERR when address is not added
+/// @return or it is used by other item
 K1_ADDR_ERR_CODES k1_addr_set(uint8_t addr, uint8_t item);
 
 /// Get address for item
@@ -36,4 +45,14 @@ K1_ADDR_ERR_CODES k1_addr_set(uint8_t addr, uint8_t item);
 /// @return address of the item or 0 when it's not defined
 uint8_t k1_addr_get(uint8_t item);
 
+/// Check the address is one of the item addresses, it is called from interrupts
+/// @param addr address [0 - 255]
+/// @return 1 - an item of the device has the address, 0 - no
+uint8_t k1_addr_is_own(uint8_t addr);
+
+/// Get item for address, it is called from interrupts
+/// @param addr address [0 - 255]
+/// @return item's number or K1_ADDR_NO_ITEM
+uint8_t k1_addr_get_item(uint8_t addr);
+
 #endif // #ifndef INC_K1_ADDR_H_
@@ -0,0 +1,104 @@
+/// *****************************************************************************
+/// @file           : k1-capture.h
+/// @brief          : k1 line pulse decoder (TIM4 input capture + DMA)
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// KC_SD_v1.0(PCB) section 4
+/// 4. Интерфейсы и подключения
+/// - Адресная линия K1
+///
+/// k1_capture (PB6, TI1 of TIM4) is measured in PWM input mode: the rising
+/// edge resets TIM4 and is captured by CH1 (symbol period), the falling edge
+/// is captured by CH2 (pulse width). Every CH2 capture makes a DMA burst read
+/// of CCR1 and CCR2 into the capture buffer, so edges cost no CPU.
+/// TIM4 overflows when the line is quiet for K1_PHY_FRAME_GAP_US, this
+/// update interrupt ends the frame and swaps the double buffer. The first
+/// edge of the next frame arms the update interrupt again, so the CPU is
+/// involved twice per frame. Symbols are decoded in bulk by the main loop.
+
+#ifndef INC_K1_CAPTURE_H_
+#define INC_K1_CAPTURE_H_
+
+#include "main.h"
+#include "k1-phy.h"
+
+/// maximal length of decoded frame
+#define K1_CAP_FRAME_MAX_LEN   16U
+/// SYNC and bits of the frame
+#define K1_CAP_SYMBOLS_MAX     (1U + 8U * K1_CAP_FRAME_MAX_LEN)
+
+/// symbols of the line
+enum
+{
+  K1_CAP_SYMBOL_BIT0 = 0,
+  K1_CAP_SYMBOL_BIT1,
+  K1_CAP_SYMBOL_SYNC,
+  K1_CAP_SYMBOLS_AMOUNT
+};
+
+/// pulse width range of a symbol, us
+typedef struct
+{
+  uint16_t min_us;
+  uint16_t max_us;
+} k1_cap_range_type;
+
+/// timing table of the line
+typedef struct
+{
+  uint16_t glitch_us;                               // shorter pulses are noise
+  k1_cap_range_type period;                         // period of a symbol
+  k1_cap_range_type symbol[K1_CAP_SYMBOLS_AMOUNT];  // pulse width of symbols
+} k1_cap_timing_type;
+
+/// counters of the decoder
+typedef struct
+{
+  uint32_t frames;        // frames decoded without errors
+  uint32_t bad_frames;    // frames with errors, dropped
+  uint32_t glitches;      // pulses shorter than glitch_us
+  uint32_t out_of_spec;   // pulses or periods outside of the timing table
+  uint32_t overflow;      // frames dropped, the main loop is too slow
+  uint32_t too_long;      // frames longer than K1_CAP_SYMBOLS_MAX
+} k1_cap_stats_type;
+
+typedef enum
+{
+  K1_CAP_OK,
+  K1_CAP_ERR
+} K1_CAP_ERR_CODES;
+
+/// @name k1_cap_init
+/// @brief The function starts TIM4 capture with default timing table.
+/// @param tim timer of k1_capture input, 1 us tick, PWM input mode with
+/// @param     CH2 DMA linked
+/// @return K1_CAP_OK or K1_CAP_ERR
+K1_CAP_ERR_CODES k1_cap_init(TIM_HandleTypeDef * tim);
+
+/// Set timing table of the line
+/// @param timing timing table, it is copied
+void k1_cap_set_timing(const k1_cap_timing_type * timing);
+
+/// @name k1_cap_frame_get
+/// @brief The function decodes the captured frame in bulk.
+/// @param buf buffer for the decoded bytes
+/// @param size size of the buffer
+/// @return number of decoded bytes, 0 - no frame or frame has errors
+uint8_t k1_cap_frame_get(uint8_t * buf, uint8_t size);
+
+/// Copy the counters of the decoder
+/// @param stats pointer to store the counters
+void k1_cap_get_stats(k1_cap_stats_type * stats);
+
+/// TIM4 update interrupt, the line is quiet
+void k1_cap_frame_end_isr(void);
+
+/// TIM4 CH1 capture interrupt, the first edge of a frame
+void k1_cap_frame_start_isr(void);
+
+#endif // #ifndef INC_K1_CAPTURE_H_
@@ -0,0 +1,122 @@
+/// *****************************************************************************
+/// @file           : k1-dup.h
+/// @brief          : detector of duplicate k1 bus addresses
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// KC_SD_v1.0(PCB) section 2
+/// 5. Состояния и события (по K1)
+/// - Дублирующий адрес
+///
+/// Two devices with the same address answer one POLL at the same time. The
+/// capture input decodes every reply on the line, our own reply included:
+/// its echo must be the frame k1_tx has sent. Every reply carries a random
+/// challenge byte, so the replies of two devices differ.
+/// A frame with a valid CRC, the STATE command and our address which is not
+/// our reply is a collision: the item keeps silent for a random number of
+/// POLLs seeded by the UID of the MCU. A reply with our address heard during
+/// the silence is the other device, the duplicate is confirmed. A quiet
+/// back-off returns the item to the normal state.
+/// A lost or corrupt echo is not a proof: a noise glitch does the same as
+/// the overlap of two replies. Only K1_DUP_LOST_MAX lost echoes in a row
+/// start the back-off, the silence lets the reply of the other device
+/// through. An item in FIRE or ATTENTION never keeps silent, its back-off
+/// ends at once.
+/// The confirmed item goes on replying (with the state DUPLICATE), so the
+/// other device confirms the duplicate too. A new address of the item
+/// resets the detector by k1_dup_reset().
+/// The detector runs in the K1 task only.
+
+#ifndef INC_K1_DUP_H_
+#define INC_K1_DUP_H_
+
+#include "main.h"
+#include "device-config.h"
+#include "k1-phy.h"
+#include "k1-tx.h"
+
+/// longest back-off, POLLs of the item
+#define K1_DUP_BACKOFF_MAX      8U
+/// lost or corrupt echoes in a row which start the back-off
+#define K1_DUP_LOST_MAX         4U
+/// time from the start of the reply to its decoded echo: the longest frame
+/// and the quiet line which ends it
+#define K1_DUP_ECHO_TIMEOUT_MS  ((K1_TX_SYMBOLS_MAX * K1_PHY_BIT_PERIOD_US) / 1000U + 5U)
+
+/// states of the item
+typedef enum
+{
+  K1_DUP_NORM,                  // echoes are clean
+  K1_DUP_BACKOFF,               // collision, the item keeps silent
+  K1_DUP_CONFIRMED              // another device has the address
+} k1_dup_state_type;
+
+/// counters of the detector
+typedef struct
+{
+  uint32_t echoes;              // clean echoes of our replies
+  uint32_t lost;                // lost or corrupt echoes
+  uint32_t collisions;          // foreign replies with our address
+  uint32_t cleared;             // back-offs ended with no foreign reply
+  uint32_t confirmed;           // duplicates confirmed
+  uint32_t alarm_holds;         // back-offs not started or ended by alarms
+} k1_dup_stats_type;
+
+/// handler of the confirmed duplicate
+/// @param item item's number in the device
+typedef void (*k1_dup_handler_type)(uint8_t item);
+
+/// @name k1_dup_init
+/// @brief The function seeds the random generator and resets all items.
+/// @param seed seed of the generator, the UID of the MCU
+void k1_dup_init(uint32_t seed);
+
+/// Set the handler of the confirmed duplicate, it runs in the K1 task
+/// @param handler handler or 0
+void k1_dup_set_handler(k1_dup_handler_type handler);
+
+/// Reset the item to K1_DUP_NORM, the address of the item has changed
+/// @param item item's number in the device [0 - K1_NUM_OF_ITEMS)
+void k1_dup_reset(uint8_t item);
+
+/// @name k1_dup_challenge
+/// @brief The function gives the random challenge byte of the next reply.
+/// @return challenge byte
+uint8_t k1_dup_challenge(void);
+
+/// @name k1_dup_poll
+/// @brief The function counts the POLL to the item, it ends the back-off.
+/// @param item item's number in the device
+void k1_dup_poll(uint8_t item);
+
+/// @name k1_dup_frame
+/// @brief The function checks the reply captured on the line.
+/// @param buf decoded bytes of k1_cap_frame_get()
+/// @param len number of the bytes
+void k1_dup_frame(const uint8_t * buf, uint8_t len);
+
+/// @name k1_dup_handler
+/// @brief The function takes the started replies, finds lost echoes and
+/// @brief ends the back-off of the items in alarm.
+void k1_dup_handler(void);
+
+/// @name k1_dup_may_reply
+/// @brief The function tells the item may answer POLL.
+/// @param item item's number in the device
+/// @return 1 - the reply may be armed, 0 - the item keeps silent
+uint8_t k1_dup_may_reply(uint8_t item);
+
+/// Get the state of the item
+/// @param item item's number in the device
+/// @return state of the item
+k1_dup_state_type k1_dup_get_state(uint8_t item);
+
+/// Copy the counters of the detector
+/// @param stats pointer to store the counters
+void k1_dup_get_stats(k1_dup_stats_type * stats);
+
+#endif // #ifndef INC_K1_DUP_H_
@@ -0,0 +1,115 @@
+/// *****************************************************************************
+/// @file           : k1-frame.h
+/// @brief          : k1 bus frame parser
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// KC_SD_v1.0(PCB) section 2
+/// 2. Адресация
+/// - Использует 1 адрес в системе K1
+///
+/// Frame of the K1 bus:
+/// | dst | src | cmd | len | payload[len] | crc32 (MSB first) |
+/// crc32 is CRC-32/MPEG-2 (poly 0x04C11DB7, init 0xFFFFFFFF, no reflection)
+/// over all bytes from dst to the end of payload.
+/// Frames are parsed in place in the receive ring buffer, nothing is copied.
+
+#ifndef INC_K1_FRAME_H_
+#define INC_K1_FRAME_H_
+
+#include "main.h"
+#include "k1-rx.h"
+
+/// offsets of the frame header fields
+#define K1_FRAME_DST_POS       0U
+#define K1_FRAME_SRC_POS       1U
+#define K1_FRAME_CMD_POS       2U
+#define K1_FRAME_LEN_POS       3U
+#define K1_FRAME_HDR_LEN       4U
+#define K1_FRAME_CRC_LEN       4U
+/// maximal payload which fits into the receive engine
+#define K1_FRAME_PAYLOAD_MAX   (K1_RX_FRAME_MAX_LEN - K1_FRAME_HDR_LEN - K1_FRAME_CRC_LEN)
+
+/// commands
+#define K1_FRAME_CMD_POLL      0x01U // pult requests the state of the item
+#define K1_FRAME_CMD_STATE     0x02U // reply with the state of the item:
+                                     // | state | supply health, 100 mV |
+                                     // | challenge |, the random challenge
+                                     // finds duplicate addresses (k1-dup)
+
+typedef enum
+{
+  K1_FRAME_OK,
+  K1_FRAME_LEN_ERR,   // frame length does not match the len field
+  K1_FRAME_CRC_ERR    // wrong CRC
+} K1_FRAME_ERR_CODES;
+
+/// parsed frame, the payload stays in the receive buffer
+typedef struct
+{
+  k1_rx_frame_type raw; // received bytes
+  uint8_t dst;          // destination address
+  uint8_t src;          // source address
+  uint8_t cmd;          // command
+  uint8_t len;          // payload length
+} k1_frame_type;
+
+/// Get payload byte of the parsed frame
+/// @param frame parsed frame
+/// @param idx index of the byte in the payload [0 - frame->len)
+/// @return byte value
+static inline uint8_t k1_frame_payload_byte(const k1_frame_type * frame, uint8_t idx)
+{
+  return k1_rx_frame_byte(&frame->raw, (uint16_t)(K1_FRAME_HDR_LEN + idx));
+}
+
+/// @name k1_frame_addr_match
+/// @brief The function checks the destination address of the frame. It is
+/// @brief used by the receive engine in the interrupt at the frame end.
+/// @param dst destination address
+/// @return 1 - frame is for this device: one of its item addresses, broadcast
+/// @return     or the central pult (replies of other devices, needed for the
+/// @return     duplicate address control), 0 - frame is for other device
+uint8_t k1_frame_addr_match(uint8_t dst);
+
+/// @name k1_frame_parse
+/// @brief The function decodes the header and checks length and CRC of the
+/// @brief received frame.
+/// @param raw received frame
+/// @param frame pointer to store the parsed frame
+/// @return K1_FRAME_OK or error code
+K1_FRAME_ERR_CODES k1_frame_parse(const k1_rx_frame_type * raw, k1_frame_type * frame);
+
+/// @name k1_frame_check_isr
+/// @brief The function checks length and CRC of the received frame with
+/// @brief software CRC, it is used in interrupts before the frame is parsed.
+/// @param raw received frame
+/// @return K1_FRAME_OK or error code
+K1_FRAME_ERR_CODES k1_frame_check_isr(const k1_rx_frame_type * raw);
+
+/// @name k1_frame_check_bytes
+/// @brief The function checks length and CRC of the frame in a flat
+/// @brief buffer, e.g. decoded from the line by k1_cap_frame_get().
+/// @param buf bytes of the frame
+/// @param len number of the bytes
+/// @return K1_FRAME_OK or error code
+K1_FRAME_ERR_CODES k1_frame_check_bytes(const uint8_t * buf, uint16_t len);
+
+/// @name k1_frame_build
+/// @brief The function makes a frame with CRC for transmission.
+/// @param buf buffer for the frame, at least
+/// @param     K1_FRAME_HDR_LEN + len + K1_FRAME_CRC_LEN bytes
+/// @param dst destination address
+/// @param src source address
+/// @param cmd command
+/// @param payload payload bytes
+/// @param len payload length
+/// @return length of the frame
+uint16_t k1_frame_build(uint8_t * buf, uint8_t dst, uint8_t src, uint8_t cmd,
+                        const uint8_t * payload, uint8_t len);
+
+#endif // #ifndef INC_K1_FRAME_H_
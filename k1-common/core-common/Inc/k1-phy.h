@@ -0,0 +1,44 @@
+/// *****************************************************************************
+/// @file           : k1-phy.h
+/// @brief          : k1 bus physical layer timings
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// KC_SD_v1.0(PCB) section 4
+/// 4. Интерфейсы и подключения
+/// - Адресная линия K1
+///
+/// Replies of the devices are pulse width coded current pulses:
+/// every symbol takes K1_PHY_BIT_PERIOD_US, the symbol value is given by the
+/// width of the pulse at the period begin. A frame starts with the SYNC
+/// symbol, then bytes follow MSB first. Timers which drive and capture the
+/// line count K1_PHY_TICK_HZ.
+
+#ifndef INC_K1_PHY_H_
+#define INC_K1_PHY_H_
+
+/// timer tick of K1 line, 1 us
+#define K1_PHY_TICK_HZ          1000000U
+
+/// period of one symbol
+#define K1_PHY_BIT_PERIOD_US    100U
+/// pulse widths of the symbols
+#define K1_PHY_BIT0_PULSE_US    25U
+#define K1_PHY_BIT1_PULSE_US    75U
+#define K1_PHY_SYNC_PULSE_US    50U
+
+/// pause between the end of the request and the reply
+#define K1_PHY_TURNAROUND_US    200U
+
+/// receive side: allowed deviation of pulses and periods
+#define K1_PHY_TOLERANCE_US     10U
+/// pulses shorter than this are noise
+#define K1_PHY_GLITCH_US        5U
+/// line without edges longer than this ends the frame (TIM4 period)
+#define K1_PHY_FRAME_GAP_US     (3U * K1_PHY_BIT_PERIOD_US)
+
+#endif // #ifndef INC_K1_PHY_H_
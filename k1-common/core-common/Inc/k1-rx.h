@@ -0,0 +1,130 @@
+/// *****************************************************************************
+/// @file           : k1-rx.h
+/// @brief          : k1 bus receive engine (USART2 + DMA1 circular buffer)
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// KC_SD_v1.0(PCB) section 4
+/// 4. Интерфейсы и подключения
+/// - Адресная линия K1
+///
+/// Bytes of the K1 bus are written by DMA1 channel 6 into a circular buffer
+/// without CPU. The end of a frame is detected by USART IDLE line, so the CPU
+/// is involved once per frame (plus half/complete buffer events). Complete
+/// frames are handed to the application in place, as a window of the ring
+/// buffer, and stay valid until k1_rx_frame_release() is called.
+/// An optional filter checks the first (destination) byte of every frame in
+/// the interrupt, frames rejected by it are never queued and never reach the
+/// end handler. The filter runs at the first Rx event of the frame, it is
+/// the IDLE line of the frame end unless the frame crosses a half of the
+/// ring buffer (DMA half/complete). The frame is received to the end anyway,
+/// the filter saves the queue, the CRC and the handler.
+
+#ifndef INC_K1_RX_H_
+#define INC_K1_RX_H_
+
+#include "main.h"
+#include "time-base.h"
+
+/// size of the DMA ring buffer, must be a power of 2
+#define K1_RX_BUF_SIZE         256U
+#define K1_RX_BUF_MASK         (K1_RX_BUF_SIZE - 1U)
+/// number of complete frames waiting for the application, power of 2
+#define K1_RX_QUEUE_SIZE       8U
+/// maximal length of K1 frame, longer bursts are dropped
+#define K1_RX_FRAME_MAX_LEN    64U
+
+typedef enum
+{
+  K1_RX_OK,
+  K1_RX_ERR
+} K1_RX_ERR_CODES;
+
+/// received frame, a window of the ring buffer (may wrap over its end)
+typedef struct
+{
+  const uint8_t * buf;  // base of the ring buffer
+  uint16_t start;       // index of the first byte in the ring buffer
+  uint16_t len;         // number of bytes in the frame
+  uint64_t end_us;      // time of the frame end (IDLE line), time_base_us()
+} k1_rx_frame_type;
+
+/// counters of the receive engine
+typedef struct
+{
+  uint32_t frames;          // frames handed to the application
+  uint32_t overrun;         // USART overrun errors (ORE)
+  uint32_t noise;           // USART noise errors (NE)
+  uint32_t framing;         // USART framing errors (FE)
+  uint32_t parity;          // USART parity errors (PE)
+  uint32_t queue_overflow;  // frames dropped, the application is too slow
+  uint32_t buf_overrun;     // frames overwritten by DMA before release
+  uint32_t too_long;        // bursts longer than K1_RX_FRAME_MAX_LEN
+  uint32_t filtered;        // frames rejected by the address filter
+} k1_rx_stats_type;
+
+/// filter of frames by the first byte, called from interrupt
+/// @param dst first byte of the frame (destination address)
+/// @return 1 - frame is accepted, 0 - frame is dropped
+typedef uint8_t (*k1_rx_filter_type)(uint8_t dst);
+
+/// handler of the frame end (IDLE line) for accepted frames, called from
+/// interrupt for time critical reactions (reply turnaround)
+/// @param frame received frame
+typedef void (*k1_rx_end_handler_type)(const k1_rx_frame_type * frame);
+
+/// Get byte of the received frame
+/// @param frame received frame
+/// @param idx index of the byte in the frame [0 - frame->len)
+/// @return byte value
+static inline uint8_t k1_rx_frame_byte(const k1_rx_frame_type * frame, uint16_t idx)
+{
+  return frame->buf[(frame->start + idx) & K1_RX_BUF_MASK];
+}
+
+/// @name k1_rx_init
+/// @brief The function starts circular DMA reception on the K1 UART.
+/// @param uart UART of the K1 bus, its hdmarx must be linked to a circular
+/// @param      DMA channel
+/// @return K1_RX_OK or K1_RX_ERR
+K1_RX_ERR_CODES k1_rx_init(UART_HandleTypeDef * uart);
+
+/// Set the filter of frames
+/// @param filter filter function or 0 to accept all frames
+void k1_rx_set_filter(k1_rx_filter_type filter);
+
+/// Set the handler of the frame end
+/// @param handler handler function or 0
+void k1_rx_set_end_handler(k1_rx_end_handler_type handler);
+
+/// @name k1_rx_frame_peek
+/// @brief The function returns the oldest received frame without removing it.
+/// @param frame pointer to store the frame window
+/// @return 1 - frame is available, 0 - no frames
+uint8_t k1_rx_frame_peek(k1_rx_frame_type * frame);
+
+/// @name k1_rx_frame_release
+/// @brief The function removes the oldest frame from the queue. It checks
+/// @brief that DMA has not overwritten the frame while it was processed.
+/// @return K1_RX_OK - frame data was valid till release,
+/// @return K1_RX_ERR - frame was overwritten, its processing result is invalid
+K1_RX_ERR_CODES k1_rx_frame_release(void);
+
+/// Copy the counters of the receive engine
+/// @param stats pointer to store the counters
+void k1_rx_get_stats(k1_rx_stats_type * stats);
+
+/// Rx event from UART interrupt (half, complete or IDLE)
+/// @param pos DMA write position in the ring buffer [0 - K1_RX_BUF_SIZE]
+/// @param idle 1 - IDLE line was detected, the frame is complete
+void k1_rx_event_isr(uint16_t pos, uint8_t idle);
+
+/// Rx error from UART interrupt, reception is restarted
+/// @param error_code HAL_UART_ERROR_xxx combination
+void k1_rx_error_isr(uint32_t error_code);
+
+#endif // #ifndef INC_K1_RX_H_
@@ -0,0 +1,109 @@
+/// *****************************************************************************
+/// @file           : k1-tx.h
+/// @brief          : k1 bus reply transmitter (TIM1 CH1 + DMA1 channel 5)
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// KC_SD_v1.0(PCB) section 4
+/// 4. Интерфейсы и подключения
+/// - Адресная линия K1
+///
+/// The application arms a reply for the item in advance. When a POLL request
+/// to the item ends (IDLE line of the K1 receiver), the interrupt starts TIM1:
+/// the first timer period is the turnaround pause, then every update event
+/// makes DMA load the pulse width of the next symbol into CCR1 (k1_pwm1).
+/// The reply delay is set by the timer, not by the main loop.
+
+#ifndef INC_K1_TX_H_
+#define INC_K1_TX_H_
+
+#include "main.h"
+#include "device-config.h"
+#include "k1-rx.h"
+
+/// maximal length of reply frame
+#define K1_TX_FRAME_MAX_LEN    16U
+/// SYNC, bits of the frame and 2 idle symbols which stop the line
+#define K1_TX_SYMBOLS_MAX      (1U + 8U * K1_TX_FRAME_MAX_LEN + 2U)
+
+typedef enum
+{
+  K1_TX_OK,
+  K1_TX_ERR
+} K1_TX_ERR_CODES;
+
+/// counters of the transmitter
+typedef struct
+{
+  uint32_t sent;        // replies transmitted
+  uint32_t busy;        // requests while the previous reply was transmitted
+  uint32_t not_armed;   // requests to the item without armed reply
+  uint32_t dma_err;     // DMA transfer errors
+  uint32_t rejected;    // POLL requests with wrong length or CRC
+} k1_tx_stats_type;
+
+/// the last started reply, the line must echo it
+typedef struct
+{
+  uint8_t frame[K1_TX_FRAME_MAX_LEN];
+  uint8_t len;
+  uint8_t item;         // item's number of the reply
+  uint32_t seq;         // number of the started replies, 0 - none yet
+} k1_tx_last_type;
+
+/// @name k1_tx_init
+/// @brief The function initializes the transmitter.
+/// @param tim timer of the K1 line, 1 us tick, CH1 in PWM mode with
+/// @param     update DMA linked
+/// @return K1_TX_OK or K1_TX_ERR
+K1_TX_ERR_CODES k1_tx_init(TIM_HandleTypeDef * tim);
+
+/// Set pause between the end of the request and the reply
+/// @param turnaround_us pause in us, counted from IDLE line detection
+void k1_tx_set_turnaround(uint16_t turnaround_us);
+
+/// @name k1_tx_arm
+/// @brief The function prepares the reply of the item to the next POLL.
+/// @param item item's number in the device [0 - K1_NUM_OF_ITEMS)
+/// @param cmd command of the reply
+/// @param payload payload bytes
+/// @param len payload length
+/// @return K1_TX_OK or K1_TX_ERR
+K1_TX_ERR_CODES k1_tx_arm(uint8_t item, uint8_t cmd, const uint8_t * payload, uint8_t len);
+
+/// Drop the armed reply of the item, it does not answer the next POLL
+/// @param item item's number in the device [0 - K1_NUM_OF_ITEMS)
+void k1_tx_disarm(uint8_t item);
+
+/// Check the reply of the item is armed
+/// @param item item's number in the device [0 - K1_NUM_OF_ITEMS)
+/// @return 1 - armed, 0 - sent or not armed
+uint8_t k1_tx_is_armed(uint8_t item);
+
+/// Check the reply is being transmitted
+/// @return 1 - transmitting, 0 - line is free
+uint8_t k1_tx_is_busy(void);
+
+/// Get the replies of the item started on the line
+/// @param item item's number in the device [0 - K1_NUM_OF_ITEMS)
+/// @param start_us pointer to store the start of the last reply or 0
+/// @return number of the started replies of the item
+uint32_t k1_tx_get_started(uint8_t item, uint64_t * start_us);
+
+/// Copy the last started reply
+/// @param last pointer to store the reply
+void k1_tx_get_last(k1_tx_last_type * last);
+
+/// Copy the counters of the transmitter
+/// @param stats pointer to store the counters
+void k1_tx_get_stats(k1_tx_stats_type * stats);
+
+/// Handler of the request end, see k1_rx_set_end_handler
+/// @param frame received frame
+void k1_tx_request_end_isr(const k1_rx_frame_type * frame);
+
+#endif // #ifndef INC_K1_TX_H_
@@ -0,0 +1,98 @@
+/// *****************************************************************************
+/// @file           : scheduler.h
+/// @brief          : cooperative scheduler with static task table
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// The application describes its tasks by a const table. Periodic tasks run
+/// every period_ms, one-shot tasks (period_ms == 0) run once after
+/// sched_start(). When several tasks are due, the task with the highest
+/// priority (lowest value) runs first, so alarm processing goes ahead of
+/// housekeeping. Tasks run to completion, one at a time.
+/// When no task is due the CPU sleeps by __WFI() till the next interrupt,
+/// at least SysTick wakes it every 1 ms. The last check before the sleep is
+/// done with the interrupts masked, a task started by an interrupt before
+/// __WFI() wakes the CPU at once.
+/// A start later than deadline_ms after the due time counts a deadline miss.
+/// Times are taken from the 64-bit time base, they do not wrap.
+/// The choice of the task and the update of its time run with the
+/// interrupts masked, a restart by sched_start() from an interrupt is never
+/// lost: it wins if it comes before the choice, else it replaces the next
+/// time set by the dispatcher.
+
+#ifndef INC_SCHEDULER_H_
+#define INC_SCHEDULER_H_
+
+#include "main.h"
+#include "time-base.h"
+
+/// maximal number of tasks in the table
+#define SCHED_TASKS_MAX    8U
+
+typedef enum
+{
+  SCHED_OK,
+  SCHED_ERR
+} SCHED_ERR_CODES;
+
+/// task function, it must return quickly
+typedef void (*sched_func_type)(void);
+
+/// description of the task
+typedef struct
+{
+  sched_func_type func;   // task function
+  uint32_t period_ms;     // run period, 0 - one-shot task
+  uint32_t deadline_ms;   // allowed delay of the start, 0 - no deadline
+  uint8_t priority;       // 0 - the highest priority
+} sched_task_type;
+
+/// counters of the task
+typedef struct
+{
+  uint32_t runs;          // number of runs
+  uint32_t misses;        // starts later than deadline_ms
+  uint32_t max_late_ms;   // worst delay of the start
+} sched_stats_type;
+
+/// @name sched_init
+/// @brief The function takes the task table. Periodic tasks are due at once,
+/// @brief one-shot tasks wait for sched_start().
+/// @param tasks table of the tasks, it must stay valid
+/// @param num number of the tasks [1 - SCHED_TASKS_MAX]
+/// @return SCHED_OK or SCHED_ERR
+SCHED_ERR_CODES sched_init(const sched_task_type * tasks, uint8_t num);
+
+/// @name sched_start
+/// @brief The function (re)starts the task after the delay. It may be called
+/// @brief from interrupts.
+/// @param task index of the task in the table
+/// @param delay_ms delay of the start
+/// @return SCHED_OK or SCHED_ERR
+SCHED_ERR_CODES sched_start(uint8_t task, uint32_t delay_ms);
+
+/// Stop the task
+/// @param task index of the task in the table
+/// @return SCHED_OK or SCHED_ERR
+SCHED_ERR_CODES sched_stop(uint8_t task);
+
+/// @name sched_dispatch
+/// @brief The function runs one due task with the highest priority.
+/// @return 1 - a task has run, 0 - no task is due
+uint8_t sched_dispatch(void);
+
+/// @name sched_run
+/// @brief The function runs the tasks forever, the CPU sleeps between them.
+void sched_run(void);
+
+/// Copy the counters of the task
+/// @param task index of the task in the table
+/// @param stats pointer to store the counters
+/// @return SCHED_OK or SCHED_ERR
+SCHED_ERR_CODES sched_get_stats(uint8_t task, sched_stats_type * stats);
+
+#endif // #ifndef INC_SCHEDULER_H_
@@ -0,0 +1,158 @@
+/// *****************************************************************************
+/// @file           : sec-loop.h
+/// @brief          : classification of security loops by their resistance
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// Inputs security1..6 measure the voltage of the loops of address labels.
+/// The voltage of the loop depends on its resistance and on the supply, so
+/// the filtered value of the input is compared with the zones of the input
+/// as a ratio to the filtered v_in_mon value. The zones are given by their
+/// upper bounds in ascending order, the last zone has no upper bound.
+/// To leave the zone the ratio must go beyond its bounds by the hysteresis,
+/// then the new state must hold for the integration time of the input.
+/// Classification runs in the ADC DMA interrupt on every new filtered
+/// value, a state change calls the event handler at once.
+/// Fast path: the analog watchdog of ADC watches the raw samples of one
+/// input marked fast, the window is the zone of its state with the
+/// hysteresis scaled by the supply. When SEC_LOOP_FAST_SAMPLES successive
+/// samples are out of the window in an alarm zone, the alarm is set from
+/// the watchdog interrupt without the filter delay and the integration.
+/// The window is updated with every filtered value of the supply.
+/// The watchdog may fire before DMA has written the sample, then the sample
+/// read is the previous one, inside the window. Such a read proves nothing:
+/// the watchdog stays armed and the next scan is read, only a second one in
+/// a row disarms it till the next filtered value.
+
+#ifndef INC_SEC_LOOP_H_
+#define INC_SEC_LOOP_H_
+
+#include "main.h"
+#include "adc-scan.h"
+
+/// number of security inputs
+#define SEC_LOOP_INPUTS         6U
+/// maximal number of zones of the input
+#define SEC_LOOP_ZONES_MAX      8U
+/// v_in_mon below it (Q15 of ADC full scale) holds the states, no supply
+#define SEC_LOOP_VIN_MIN_Q15    0x0400U
+/// successive samples in alarm zone to set the alarm by the fast path
+#define SEC_LOOP_FAST_SAMPLES   2U
+
+typedef enum
+{
+  SEC_LOOP_OK,
+  SEC_LOOP_ERR
+} SEC_LOOP_ERR_CODES;
+
+/// state of the loop
+typedef enum
+{
+  SEC_LOOP_UNDEFINED,     // not classified yet or the input is off
+  SEC_LOOP_NORM,
+  SEC_LOOP_ALARM,
+  SEC_LOOP_OPEN,          // open circuit
+  SEC_LOOP_SHORT,         // short circuit
+  SEC_LOOP_TAMPER,
+  SEC_LOOP_STATES
+} sec_loop_state_type;
+
+/// zone of the loop voltage
+typedef struct
+{
+  uint16_t upper_q15;         // upper bound, Q15 ratio to v_in_mon [0 - 2.0)
+  sec_loop_state_type state;  // state of the zone
+} sec_loop_zone_type;
+
+/// classifier of the input
+typedef struct
+{
+  const sec_loop_zone_type * zones;   // zones in ascending order, 0 - input is off
+  uint8_t zones_num;                  // number of zones [1 - SEC_LOOP_ZONES_MAX]
+  uint16_t hyst_q15;                  // hysteresis, Q15 ratio to v_in_mon
+  uint16_t integration_ms;            // time the new state must hold
+  uint8_t fast;                       // 1 - alarm by the analog watchdog
+} sec_loop_config_type;
+
+/// counters of the fast path
+typedef struct
+{
+  uint32_t wakeups;       // analog watchdog interrupts
+  uint32_t inconclusive;  // wakeups which read a sample inside the window
+  uint32_t alarms;        // alarms set by the fast path
+  uint32_t last_us;       // latency of the last alarm, from the start of the first scan out of the window
+  uint32_t max_us;        // worst latency
+} sec_loop_fast_stats_type;
+
+/// handler of the state change, called from ADC DMA and ADC1_2 interrupts
+/// of the same priority
+/// @param input input number [0 - SEC_LOOP_INPUTS)
+/// @param state new state of the input
+/// @param edge_us time in us the loop voltage has come into the zone
+typedef void (*sec_loop_handler_type)(uint8_t input, sec_loop_state_type state, uint64_t edge_us);
+
+/// @name sec_loop_init
+/// @brief The function copies the classifiers and resets the states.
+/// @param config classifiers of the inputs, the zones must stay valid
+/// @param num number of the used inputs [0 - SEC_LOOP_INPUTS], the rest are off
+/// @return SEC_LOOP_OK or SEC_LOOP_ERR - wrong parameters
+SEC_LOOP_ERR_CODES sec_loop_init(const sec_loop_config_type * config, uint8_t num);
+
+/// @name sec_loop_fast_init
+/// @brief The function enables the fast path by the analog watchdog.
+/// @param adc ADC of the scan
+/// @param trigger trigger timer of the scan at 1 us tick, for the latency
+/// @return SEC_LOOP_OK or SEC_LOOP_ERR
+SEC_LOOP_ERR_CODES sec_loop_fast_init(ADC_HandleTypeDef * adc, TIM_HandleTypeDef * trigger);
+
+/// Set the handler of the state changes
+/// @param handler handler function or 0
+void sec_loop_set_handler(sec_loop_handler_type handler);
+
+/// @name sec_loop_classify
+/// @brief The function finds the zone of the loop voltage with the
+/// @brief hysteresis around the zone of the current state.
+/// @param config classifier of the input
+/// @param line_q15 loop voltage, Q15 of ADC full scale
+/// @param vin_q15 supply voltage, Q15 of ADC full scale
+/// @param current index of the current zone, SEC_LOOP_ZONES_MAX - none
+/// @return index of the zone
+uint8_t sec_loop_classify(const sec_loop_config_type * config, uint16_t line_q15, uint16_t vin_q15,
+                          uint8_t current);
+
+/// @name sec_loop_update
+/// @brief The function classifies the new filtered value of the input.
+/// @param input input number [0 - SEC_LOOP_INPUTS)
+/// @param line_q15 loop voltage, Q15 of ADC full scale
+/// @param vin_q15 supply voltage, Q15 of ADC full scale
+/// @param now_us time of the value, time_base_us()
+void sec_loop_update(uint8_t input, uint16_t line_q15, uint16_t vin_q15, uint64_t now_us);
+
+/// @name sec_loop_isr
+/// @brief The function takes the new values of adc-filter, it is called
+/// @brief from ADC DMA interrupt after adc_filter_block().
+void sec_loop_isr(void);
+
+/// Analog watchdog, from ADC interrupt of the same priority as ADC DMA
+void sec_loop_awd_isr(void);
+
+/// Copy the counters of the fast path
+/// @param stats pointer to store the counters
+void sec_loop_get_fast_stats(sec_loop_fast_stats_type * stats);
+
+/// Get the state of the input
+/// @param input input number [0 - SEC_LOOP_INPUTS)
+/// @return state of the input
+sec_loop_state_type sec_loop_get_state(uint8_t input);
+
+/// Get the edge of the state
+/// @param input input number [0 - SEC_LOOP_INPUTS)
+/// @return time in us the loop voltage has come into the zone of the state,
+/// @return it precedes the state change by the integration time
+uint64_t sec_loop_get_edge_us(uint8_t input);
+
+#endif // #ifndef INC_SEC_LOOP_H_
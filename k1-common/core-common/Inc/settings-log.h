@@ -0,0 +1,106 @@
+/// *****************************************************************************
+/// @file           : settings-log.h
+/// @brief          : wear-levelled log of settings records in 2 flash pages
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// KC_SD_v1.0(PCB) section 2
+/// 2. Адресация
+/// - Использует 1 адрес в системе K1
+///
+/// Settings are kept as a journal in the pages FLASH_SETS_MAIN_ADDR and
+/// FLASH_SETS_COPY_ADDR. Every change appends a record into the erased space
+/// of the active page:
+///   | magic | version | len | ~len | payload, padded to words | crc32 |
+/// The last record with valid CRC is the current settings. When the active
+/// page is full, the other page is erased, the record is written there and
+/// the page header (magic, generation) is programmed last: an interrupted
+/// compaction leaves the old page active. So a page is erased once per
+/// tens of changes, not twice per change, and the boot only reads flash.
+///
+/// A record is written in the background: settings_log_begin() takes the
+/// payload, every settings_log_step() queues the next flash operation (the
+/// page erase, the record, the page header) to flash-async and checks its
+/// result, so the CPU never spins on the flash.
+
+#ifndef INC_SETTINGS_LOG_H_
+#define INC_SETTINGS_LOG_H_
+
+#include "main.h"
+
+/// size of the flash page
+#define SETTINGS_LOG_PAGE_SIZE      0x400U
+/// maximal payload of the record
+#define SETTINGS_LOG_PAYLOAD_MAX    128U
+
+typedef enum
+{
+  SETTINGS_LOG_OK,
+  SETTINGS_LOG_BUSY,        // the record is being written
+  SETTINGS_LOG_EMPTY,       // no valid record
+  SETTINGS_LOG_FLASH_ERR,   // erase, program or verify error
+  SETTINGS_LOG_ERR          // wrong parameters
+} SETTINGS_LOG_ERR_CODES;
+
+/// counters of the log
+typedef struct
+{
+  uint32_t appends;     // records written
+  uint32_t erases;      // pages erased
+  uint32_t bad_records; // records with wrong CRC found by the scan
+  uint32_t flash_err;   // flash errors
+} settings_log_stats_type;
+
+/// @name settings_log_init
+/// @brief The function scans both pages and finds the active page, the
+/// @brief last valid record and the free space. It does not write flash.
+/// @return SETTINGS_LOG_OK - a record is found, SETTINGS_LOG_EMPTY - no records
+SETTINGS_LOG_ERR_CODES settings_log_init(void);
+
+/// @name settings_log_read
+/// @brief The function returns the last valid record in place, in flash.
+/// @param version pointer to store the version of the payload format
+/// @param len pointer to store the length of the payload
+/// @return pointer to the payload or 0 - no valid record
+const uint8_t * settings_log_read(uint16_t * version, uint16_t * len);
+
+/// @name settings_log_begin
+/// @brief The function takes the new record for the background write, it
+/// @brief is written into the other page when the active page is full.
+/// @param payload payload of the record, it is copied
+/// @param len length of the payload [1 - SETTINGS_LOG_PAYLOAD_MAX]
+/// @param version version of the payload format
+/// @return SETTINGS_LOG_OK, SETTINGS_LOG_BUSY - the previous record is not
+/// @return written yet, SETTINGS_LOG_ERR
+SETTINGS_LOG_ERR_CODES settings_log_begin(const void * payload, uint16_t len, uint16_t version);
+
+/// @name settings_log_step
+/// @brief The function advances the write of the record by one flash
+/// @brief operation: it checks the result of the previous one and queues
+/// @brief the next one.
+/// @return SETTINGS_LOG_BUSY - the record is not complete,
+/// @return SETTINGS_LOG_OK - the record is written (or no record to write),
+/// @return SETTINGS_LOG_FLASH_ERR - the record is dropped
+SETTINGS_LOG_ERR_CODES settings_log_step(void);
+
+/// @name settings_log_append
+/// @brief The function writes the new record at once (begin and all steps).
+/// @param payload payload of the record
+/// @param len length of the payload [1 - SETTINGS_LOG_PAYLOAD_MAX]
+/// @param version version of the payload format
+/// @return SETTINGS_LOG_OK or error code
+SETTINGS_LOG_ERR_CODES settings_log_append(const void * payload, uint16_t len, uint16_t version);
+
+/// Check the background write
+/// @return 1 - the record is being written
+uint8_t settings_log_is_busy(void);
+
+/// Copy the counters of the log
+/// @param stats pointer to store the counters
+void settings_log_get_stats(settings_log_stats_type * stats);
+
+#endif // #ifndef INC_SETTINGS_LOG_H_
@@ -14,6 +14,13 @@
 /// - Использует 1 адрес в системе K1
 /// - Встроенный UID
 /// - Контроль дублирующего адреса
+///
+/// The settings record is a list of fields  | tag | len | value[len] |,
+/// described by the schema table in settings.c. Only fields which differ
+/// from their defaults are written, so every device type carries only the
+/// fields it uses. At boot an index of the fields is built, getters find a
+/// field by its tag in O(1). Records of older versions are read in place
+/// by their own index builders and rewritten as TLV by the next commit.
 
 #ifndef SETTINGS_H_
 #define SETTINGS_H_
@@ -21,8 +28,8 @@
 #include "main.h"
 #include "device-config.h"
 
-// the version of settings structure
-#define SETS_VERSION  1U
+// the version of settings format: 2 - packed structure, 3 - TLV
+#define SETS_VERSION  3U
 
 // Types of devices
 #define SETS_DEV_TYPE_UNDEFINED     0U
@@ -56,44 +63,63 @@
 #define SETS_K1_ADDR_MAX           0xFE
 #define SETS_K1_ADDR_PULT          0xFF // CENTRAL PULT ADDRESS
 
-// structure to store all settings
-typedef struct
+// tags of settings fields, never reuse a tag of a removed field
+typedef enum
 {
-  union
-  {
-    struct
-    {
-      uint32_t version; // version of settings structure
-      uint8_t  device_type; // type of this device
-      uint8_t  k1_address[K1_NUM_OF_ITEMS]; // addresses of this device
-    };
-    uint8_t * by_chars;
-    uint32_t * by_words;
-  };
-  uint32_t crc32;
-} settings_type;
+  SETS_TAG_DEVICE_TYPE,   // type of this device, 1 byte
+  SETS_TAG_K1_ADDRESS,    // addresses of this device, K1_NUM_OF_ITEMS bytes
+  SETS_TAGS_AMOUNT
+} settings_tag_type;
+
+// changed fields of settings, not written to FLASH yet
+#define SETS_DIRTY(tag)            (1UL << (tag))
+#define SETS_DIRTY_DEVICE_TYPE     SETS_DIRTY(SETS_TAG_DEVICE_TYPE)
+#define SETS_DIRTY_K1_ADDRESS      SETS_DIRTY(SETS_TAG_K1_ADDRESS)
+
+// changed bytes kept in RAM till they are written, a byte being written
+// and changed again takes 2 entries
+#define SETS_CHANGES_MAX           (2U * (1U + K1_NUM_OF_ITEMS))
 
 // error codes could be used also as OR combination
 typedef enum
 {
   SETS_OK                 = 0x00, // successful operation
   SETS_ERR                = 0x01, // unknown error
-  SETS_NO_INTERFACE_FAIL  = 0x02, // there is no CRC interface pointer
+  SETS_NO_INTERFACE_FAIL  = 0x02, // CRC service is not initialized
   SETS_TIMEOUT_FAIL       = 0x04, // I2C transaction timeout
+  SETS_OVERLAY_FAIL       = 0x08, // too many changes, settings_commit() is needed
   SETS_FLASH_FAIL         = 0x10, // FLASH read/write error
   SETS_CRC_FAIL           = 0x20, // wrong CRC
-  SETS_VERSION_FAIL       = 0x40, // wrong version
+  SETS_VERSION_FAIL       = 0x40, // unknown version, defaults are used
 } settings_err_code_type;
 
 
 /// @name settings_init
 /// @author Aleksandr Shumilov
 /// created 03.06.2025
-/// @brief The function initializes the  module.  It  reads  settings
-/// @brief from FLASH (main and spare areas), checks CRC.
-/// @param crc_interface pointer to CRC_HandleTypeDef type
+/// @brief The function initializes the  module.  It  finds  the last
+/// @brief valid record of the settings log and indexes its fields,
+/// @brief getters read them in place in FLASH. Nothing is written to FLASH.
+/// @brief CRC service (crc32_init) must be initialized before.
 /// @return SETS_OK or error code
-settings_err_code_type settings_init(CRC_HandleTypeDef * crc_interface);
+settings_err_code_type settings_init(void);
+
+/// @name settings_get_u8
+/// @brief The function reads a byte of the field: the change not written
+/// @brief yet, the record in FLASH or the default of the schema.
+/// @param tag tag of the field
+/// @param index index of the byte in the field
+/// @return value, 0 - unknown field
+uint8_t settings_get_u8(settings_tag_type tag, uint8_t index);
+
+/// @name settings_set_u8
+/// @brief The function changes a byte of the field in RAM only,
+/// @brief settings_commit() writes the changes.
+/// @param tag tag of the field
+/// @param index index of the byte in the field
+/// @param val new value
+/// @return SETS_OK, SETS_OVERLAY_FAIL or SETS_ERR - unknown field
+settings_err_code_type settings_set_u8(settings_tag_type tag, uint8_t index, uint8_t val);
 
 uint8_t settings_get_device_type();
 uint8_t settings_get_k1_address(uint8_t index);
@@ -101,4 +127,27 @@ uint8_t settings_get_k1_address(uint8_t index);
 settings_err_code_type settings_set_device_type(uint8_t val);
 settings_err_code_type settings_set_k1_address (uint8_t val, uint8_t index);
 
+/// @name settings_commit
+/// @brief The function requests the write of all changed settings as one
+/// @brief record of the log. The record is written by settings_handler().
+void settings_commit(void);
+
+/// @name settings_handler
+/// @brief The function writes the committed settings in the background,
+/// @brief it advances the write by one flash operation per call. It is
+/// @brief called every scheduler tick.
+void settings_handler(void);
+
+/// @name settings_flush
+/// @brief The function commits the changes and writes them at once, for
+/// @brief shutdown and power fail. An erase held on the weak supply
+/// @brief (flash_async_hold_erase()) is not waited for, the record is
+/// @brief completed after the release.
+/// @return SETS_OK or SETS_FLASH_FAIL - write error or the erase is held
+settings_err_code_type settings_flush(void);
+
+/// Get changed settings
+/// @return SETS_DIRTY_xxx combination, 0 - everything is in FLASH
+uint32_t settings_get_dirty(void);
+
 #endif /* SETTINGS_H_ */
@@ -0,0 +1,96 @@
+/// *****************************************************************************
+/// @file           : supply.h
+/// @brief          : monitor of the K1 loop supply on v_in_mon
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// The monitor takes every DMA block of adc_scan. The mean of the block
+/// (ADC_SCAN_BLOCK_SCANS samples, 2 ms) gives the fast value for the sag
+/// detection and the minimum/maximum envelope, the output of adc-filter
+/// gives the average. The supply is in sag below sag_mv and low below
+/// low_mv by the fast value, it is back to norm when the average is above
+/// sag_mv by the hysteresis. In sag the device sheds the load: flash erase
+/// is held, LED and buzzer PWM must not start.
+/// The envelope and the health of K1 keep their own minimum: the envelope
+/// is reset by its reader, supply_get_health() resets only the minimum of
+/// the health. Each has one reader.
+
+#ifndef INC_SUPPLY_H_
+#define INC_SUPPLY_H_
+
+#include "main.h"
+#include "adc-scan.h"
+
+typedef enum
+{
+  SUPPLY_OK,
+  SUPPLY_ERR
+} SUPPLY_ERR_CODES;
+
+/// state of the supply
+typedef enum
+{
+  SUPPLY_UNDEFINED,   // no value yet
+  SUPPLY_NORM,
+  SUPPLY_SAG,         // load is shed
+  SUPPLY_LOW          // below the safe operation
+} supply_state_type;
+
+/// thresholds of the monitor
+typedef struct
+{
+  uint16_t full_scale_mv; // supply at ADC full scale, the divider of v_in_mon
+  uint16_t sag_mv;        // sag below it
+  uint16_t low_mv;        // low below it
+  uint16_t hyst_mv;       // hysteresis of the return to norm
+} supply_config_type;
+
+/// envelope of the supply
+typedef struct
+{
+  uint16_t avg_mv;        // filtered average
+  uint16_t min_mv;        // minimum of the block means since the last reset
+  uint16_t max_mv;        // maximum of the block means since the last reset
+} supply_envelope_type;
+
+/// handler of the state change, called from ADC DMA interrupt
+/// @param state new state of the supply
+typedef void (*supply_handler_type)(supply_state_type state);
+
+/// @name supply_init
+/// @brief The function sets the thresholds and resets the state.
+/// @param config thresholds, it is copied
+/// @return SUPPLY_OK or SUPPLY_ERR - wrong thresholds
+SUPPLY_ERR_CODES supply_init(const supply_config_type * config);
+
+/// Set the handler of the state changes
+/// @param handler handler function or 0
+void supply_set_handler(supply_handler_type handler);
+
+/// @name supply_block_isr
+/// @brief The function takes the block of samples, it is called from ADC
+/// @brief DMA interrupt after adc_filter_block().
+/// @param block samples of all channels
+void supply_block_isr(const adc_scan_block_type * block);
+
+/// Get the state of the supply
+/// @return state of the supply
+supply_state_type supply_get_state(void);
+
+/// @name supply_get_envelope
+/// @brief The function copies the envelope and starts the next one.
+/// @param env pointer to store the envelope
+void supply_get_envelope(supply_envelope_type * env);
+
+/// @name supply_get_health
+/// @brief The function gives the supply health for K1, the envelope is not
+/// @brief touched.
+/// @return minimum of the supply since the last call, 100 mV units,
+/// @return 0 - no value yet
+uint8_t supply_get_health(void);
+
+#endif // #ifndef INC_SUPPLY_H_
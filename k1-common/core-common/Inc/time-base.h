@@ -0,0 +1,78 @@
+/// *****************************************************************************
+/// @file           : time-base.h
+/// @brief          : 64-bit monotonic time base (SysTick)
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// The millisecond clock counts SysTick wraps in 64 bits, it does not wrap
+/// like the 32-bit HAL tick after 49.7 days. The microsecond clock is the
+/// same count plus the cycles of SysTick->VAL in the current ms, so both
+/// clocks run on one counter: it runs in sleep (__WFI) too, unlike the DWT
+/// cycle counter. A wrap is counted by COUNTFLAG, by the tick interrupt or
+/// by a reader which comes before it, so a reader in an interrupt which has
+/// preempted SysTick never sees the time go back. The cycles are scaled to
+/// us by a multiply and a shift, no division.
+/// Both clocks may be read from the main loop and from any interrupt. Nothing
+/// else may read SysTick->CTRL, the read clears COUNTFLAG.
+/// Times are compared by the helpers below, there is no wrap to care about.
+
+#ifndef INC_TIME_BASE_H_
+#define INC_TIME_BASE_H_
+
+#include "main.h"
+
+/// @name time_base_init
+/// @brief The function takes the SysTick period for the microsecond clock.
+/// @brief SysTick must be configured (HAL_Init, SystemClock_Config) before.
+void time_base_init(void);
+
+/// Milliseconds since time_base_init()
+/// @return time in ms
+uint64_t time_base_ms(void);
+
+/// Microseconds since time_base_init()
+/// @return time in us
+uint64_t time_base_us(void);
+
+/// SysTick interrupt, called after HAL_IncTick()
+void time_base_tick_isr(void);
+
+/// Deadline after the delay
+/// @param delay_ms delay from now
+/// @return time of the deadline in ms
+static inline uint64_t time_base_deadline_ms(uint32_t delay_ms)
+{
+  return time_base_ms() + delay_ms;
+}
+
+/// Check the deadline
+/// @param deadline_ms time of the deadline in ms
+/// @return 1 - the deadline has come
+static inline uint8_t time_base_is_expired(uint64_t deadline_ms)
+{
+  return (time_base_ms() >= deadline_ms) ? 1U : 0U;
+}
+
+/// Time passed since the moment
+/// @param since_ms the moment in ms
+/// @return time passed in ms, 0 for moments in the future
+static inline uint64_t time_base_elapsed_ms(uint64_t since_ms)
+{
+  uint64_t now = time_base_ms();
+  return (now > since_ms) ? (now - since_ms) : 0U;
+}
+
+/// Time passed since the moment
+/// @param since_us the moment in us
+/// @return time passed in us, 0 for moments in the future
+static inline uint64_t time_base_elapsed_us(uint64_t since_us)
+{
+  uint64_t now = time_base_us();
+  return (now > since_us) ? (now - since_us) : 0U;
+}
+
+#endif // #ifndef INC_TIME_BASE_H_
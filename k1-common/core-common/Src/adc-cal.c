@@ -0,0 +1,94 @@
+/// *****************************************************************************
+/// @file           : adc-cal.c
+/// @brief          : calibration of ADC readings by Vrefint and temperature
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "adc-cal.h"
+#include "adc-filter.h"
+
+// fraction bits of the filtered Vrefint
+#define ADC_CAL_VREF_FRAC   4U
+
+static ADC_HandleTypeDef * adc_cal_adc = 0;
+// filtered Vrefint, 12 bit sample with ADC_CAL_VREF_FRAC fraction bits
+static uint32_t adc_cal_vref = 0;
+static volatile uint16_t adc_cal_vdda_mv = 0;
+static volatile int16_t adc_cal_temp = 0;
+static adc_cal_stats_type adc_cal_stats = {0};
+
+ADC_CAL_ERR_CODES adc_cal_init(ADC_HandleTypeDef * adc)
+{
+  ADC_CAL_ERR_CODES ret_val = ADC_CAL_ERR;
+  adc_cal_vref = 0;
+  adc_cal_vdda_mv = 0;
+  adc_filter_set_gain(ADC_FILTER_GAIN_ONE);
+  if((adc != 0) && (HAL_ADCEx_Calibration_Start(adc) == HAL_OK))
+  {
+    adc_cal_adc = adc;
+    ret_val = ADC_CAL_OK;
+  }
+  return ret_val;
+}
+
+ADC_CAL_ERR_CODES adc_cal_start(void)
+{
+  if(adc_cal_adc == 0)
+    return ADC_CAL_ERR;
+  // the start changes CR1 by read-modify-write, the ADC DMA interrupt sets
+  // the analog watchdog in CR1 too (sec-loop)
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  HAL_StatusTypeDef status = HAL_ADCEx_InjectedStart_IT(adc_cal_adc);
+  __set_PRIMASK(primask);
+  return (status == HAL_OK) ? ADC_CAL_OK : ADC_CAL_ERR;
+}
+
+void adc_cal_isr(void)
+{
+  uint32_t vref = HAL_ADCEx_InjectedGetValue(adc_cal_adc, ADC_INJECTED_RANK_1);
+  uint32_t temp = HAL_ADCEx_InjectedGetValue(adc_cal_adc, ADC_INJECTED_RANK_2);
+  ++adc_cal_stats.samples;
+
+  // gain = VDDA / nominal VDDA = Vrefint * 4096 / (vref * nominal VDDA)
+  uint32_t vref_frac = vref << ADC_CAL_VREF_FRAC;
+  uint64_t num = (uint64_t)ADC_CAL_VREFINT_MV << (12U + ADC_CAL_VREF_FRAC + ADC_FILTER_GAIN_SHIFT);
+  uint32_t gain = (vref == 0U) ? 0U : (uint32_t)(num / ((uint64_t)vref_frac * ADC_CAL_VDDA_MV));
+  if((gain < ADC_CAL_GAIN_MIN) || (gain > ADC_CAL_GAIN_MAX))
+  {
+    ++adc_cal_stats.rejected;
+    return;
+  }
+  if(adc_cal_vref == 0U)
+    adc_cal_vref = vref_frac;
+  else
+    adc_cal_vref += (int32_t)(vref_frac - adc_cal_vref) >> ADC_CAL_VREF_IIR_SHIFT;
+
+  gain = (uint32_t)(num / ((uint64_t)adc_cal_vref * ADC_CAL_VDDA_MV));
+  adc_filter_set_gain((uint16_t)gain);
+  uint32_t vdda_mv = (uint32_t)(((uint64_t)ADC_CAL_VREFINT_MV << (12U + ADC_CAL_VREF_FRAC)) / adc_cal_vref);
+  adc_cal_vdda_mv = (uint16_t)vdda_mv;
+
+  // T = (V25 - Vsense) / slope + 25 C
+  int32_t vsense_uv = (int32_t)(((uint64_t)temp * vdda_mv * 1000U) >> 12);
+  adc_cal_temp = (int16_t)((((int32_t)ADC_CAL_TEMP_V25_MV * 1000 - vsense_uv) * 10) / (int32_t)ADC_CAL_TEMP_SLOPE_UV + 250);
+}
+
+uint16_t adc_cal_get_vdda_mv(void)
+{
+  return adc_cal_vdda_mv;
+}
+
+int16_t adc_cal_get_temp(void)
+{
+  return adc_cal_temp;
+}
+
+void adc_cal_get_stats(adc_cal_stats_type * stats)
+{
+  *stats = adc_cal_stats;
+}
@@ -0,0 +1,116 @@
+/// *****************************************************************************
+/// @file           : adc-filter.c
+/// @brief          : fixed-point oversampling and decimation of ADC channels
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "adc-filter.h"
+
+// Q31 of 12 bit sample: sample << 19
+#define ADC_FILTER_SAMPLE_SHIFT   (31U - 12U)
+
+// state of the channel filter
+typedef struct
+{
+  uint32_t acc;           // sum of the samples of the decimation
+  uint16_t blocks;        // blocks in the sum
+  uint16_t blocks_num;    // blocks in the decimation
+  uint8_t shift;          // the sum to Q31
+  uint8_t iir_shift;
+  volatile int32_t y;     // output, Q31
+  volatile uint32_t outputs;
+} adc_filter_state_type;
+
+static adc_filter_state_type adc_filter_state[ADC_SCAN_CHANNELS];
+
+// gain correction, Q14
+static volatile uint16_t adc_filter_gain = ADC_FILTER_GAIN_ONE;
+
+ADC_FILTER_ERR_CODES adc_filter_init(const adc_filter_config_type * config)
+{
+  for(uint8_t ch = 0; ch < ADC_SCAN_CHANNELS; ++ch)
+  {
+    if((config[ch].osr_log2 < ADC_FILTER_BLOCK_LOG2) || (config[ch].osr_log2 > ADC_FILTER_OSR_LOG2_MAX) ||
+       (config[ch].iir_shift > ADC_FILTER_IIR_SHIFT_MAX))
+      return ADC_FILTER_ERR;
+  }
+  for(uint8_t ch = 0; ch < ADC_SCAN_CHANNELS; ++ch)
+  {
+    adc_filter_state_type * state = &adc_filter_state[ch];
+    state->acc = 0;
+    state->blocks = 0;
+    state->blocks_num = (uint16_t)(1U << (config[ch].osr_log2 - ADC_FILTER_BLOCK_LOG2));
+    state->shift = (uint8_t)(ADC_FILTER_SAMPLE_SHIFT - config[ch].osr_log2);
+    state->iir_shift = config[ch].iir_shift;
+    state->y = 0;
+    state->outputs = 0;
+  }
+  return ADC_FILTER_OK;
+}
+
+void adc_filter_block(const adc_scan_block_type * block)
+{
+  uint16_t gain = adc_filter_gain;
+  for(uint8_t ch = 0; ch < ADC_SCAN_CHANNELS; ++ch)
+  {
+    adc_filter_state_type * state = &adc_filter_state[ch];
+    if(state->blocks_num == 0U)
+      continue;
+
+    // sum of the block, 4 samples per pass with constant offsets
+    const uint16_t * p = &block->sample[0][ch];
+    uint32_t sum = 0;
+    for(uint8_t i = 0; i < ADC_SCAN_BLOCK_SCANS; i += 4U)
+    {
+      sum += (uint32_t)p[0] + p[ADC_SCAN_CHANNELS] + p[2U * ADC_SCAN_CHANNELS] + p[3U * ADC_SCAN_CHANNELS];
+      p += 4U * ADC_SCAN_CHANNELS;
+    }
+    state->acc += sum;
+    if(++state->blocks < state->blocks_num)
+      continue;
+
+    // decimated and corrected value, Q31
+    uint64_t corrected = ((uint64_t)(state->acc << state->shift) * gain) >> ADC_FILTER_GAIN_SHIFT;
+    int32_t x = (corrected > INT32_MAX) ? INT32_MAX : (int32_t)corrected;
+    state->acc = 0;
+    state->blocks = 0;
+    int32_t y = state->y;
+    if((state->outputs == 0U) || (state->iir_shift == 0U))
+      y = x;
+    else
+      y += (x - y) >> state->iir_shift;
+    state->y = y;
+    // 0 means no value
+    if(++state->outputs == 0U)
+      state->outputs = 1U;
+  }
+}
+
+void adc_filter_set_gain(uint16_t gain_q14)
+{
+  adc_filter_gain = gain_q14;
+}
+
+uint16_t adc_filter_get_gain(void)
+{
+  return adc_filter_gain;
+}
+
+int32_t adc_filter_get_q31(adc_scan_channel_type ch)
+{
+  return (ch < ADC_SCAN_CHANNELS) ? adc_filter_state[ch].y : 0;
+}
+
+int16_t adc_filter_get_q15(adc_scan_channel_type ch)
+{
+  return (int16_t)(adc_filter_get_q31(ch) >> 16);
+}
+
+uint32_t adc_filter_get_outputs(adc_scan_channel_type ch)
+{
+  return (ch < ADC_SCAN_CHANNELS) ? adc_filter_state[ch].outputs : 0U;
+}
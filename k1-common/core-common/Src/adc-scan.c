@@ -0,0 +1,98 @@
+/// *****************************************************************************
+/// @file           : adc-scan.c
+/// @brief          : timer triggered scan of ADC1 channels into DMA blocks
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "adc-scan.h"
+
+// number of samples in the DMA buffer
+#define ADC_SCAN_BUF_LEN  (2U * ADC_SCAN_BLOCK_SCANS * ADC_SCAN_CHANNELS)
+
+// DMA buffer: 2 blocks, the first one is filled till the half transfer
+static adc_scan_block_type adc_scan_buf[2];
+
+// ADC channels of the scan, order of the ranks
+static const uint32_t ADC_SCAN_ADC_CHANNELS[ADC_SCAN_CHANNELS] =
+{
+  [ADC_SCAN_V_IN] =      ADC_CHANNEL_1,
+  [ADC_SCAN_SECURITY1] = ADC_CHANNEL_4,
+  [ADC_SCAN_SECURITY2] = ADC_CHANNEL_5,
+  [ADC_SCAN_SECURITY3] = ADC_CHANNEL_6,
+  [ADC_SCAN_SECURITY4] = ADC_CHANNEL_7,
+  [ADC_SCAN_SECURITY5] = ADC_CHANNEL_8,
+  [ADC_SCAN_SECURITY6] = ADC_CHANNEL_9,
+};
+
+// ADC of the scan
+static ADC_HandleTypeDef * adc_scan_adc = 0;
+
+// handler of complete blocks
+static volatile adc_scan_handler_type adc_scan_handler = 0;
+
+// counters
+static adc_scan_stats_type adc_scan_stats = {0};
+
+ADC_SCAN_ERR_CODES adc_scan_init(ADC_HandleTypeDef * adc, TIM_HandleTypeDef * trigger)
+{
+  ADC_SCAN_ERR_CODES ret_val = ADC_SCAN_ERR;
+  if((adc != 0) && (adc->DMA_Handle != 0) && (trigger != 0) &&
+     (adc->Init.NbrOfConversion == ADC_SCAN_CHANNELS))
+  {
+    if((HAL_ADC_Start_DMA(adc, (uint32_t *)adc_scan_buf, ADC_SCAN_BUF_LEN) == HAL_OK) &&
+       (HAL_TIM_Base_Start(trigger) == HAL_OK))
+    {
+      adc_scan_adc = adc;
+      ret_val = ADC_SCAN_OK;
+    }
+  }
+  return ret_val;
+}
+
+void adc_scan_set_handler(adc_scan_handler_type handler)
+{
+  adc_scan_handler = handler;
+}
+
+void adc_scan_get_stats(adc_scan_stats_type * stats)
+{
+  *stats = adc_scan_stats;
+}
+
+uint32_t adc_scan_get_adc_channel(adc_scan_channel_type ch)
+{
+  return (ch < ADC_SCAN_CHANNELS) ? ADC_SCAN_ADC_CHANNELS[ch] : ADC_SCAN_ADC_CHANNELS[0];
+}
+
+uint16_t adc_scan_get_latest(adc_scan_channel_type ch)
+{
+  if((adc_scan_adc == 0) || (ch >= ADC_SCAN_CHANNELS))
+    return 0;
+  // DMA counter tells the next sample to be written
+  uint32_t next = ADC_SCAN_BUF_LEN - __HAL_DMA_GET_COUNTER(adc_scan_adc->DMA_Handle);
+  if(next >= ADC_SCAN_BUF_LEN)
+    next = 0;
+  uint32_t scan = next - (next % ADC_SCAN_CHANNELS);
+  // the channel is not written yet in the current scan, take the previous one
+  if((next % ADC_SCAN_CHANNELS) <= ch)
+    scan = (scan == 0U) ? (ADC_SCAN_BUF_LEN - ADC_SCAN_CHANNELS) : (scan - ADC_SCAN_CHANNELS);
+  const volatile uint16_t * samples = &adc_scan_buf[0].sample[0][0];
+  return samples[scan + ch];
+}
+
+void adc_scan_block_isr(uint8_t half)
+{
+  ++adc_scan_stats.blocks;
+  adc_scan_handler_type handler = adc_scan_handler;
+  if(handler != 0)
+    handler(&adc_scan_buf[half ? 0U : 1U]);
+}
+
+void adc_scan_error_isr(void)
+{
+  ++adc_scan_stats.errors;
+}
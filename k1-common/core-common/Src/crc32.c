@@ -0,0 +1,211 @@
+/// *****************************************************************************
+/// @file           : crc32.c
+/// @brief          : shared CRC-32 service (CRC unit + software fallback)
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "crc32.h"
+
+// CRC of every nibble value placed in the top 4 bits, 64 bytes of flash
+// instead of 1KB of a byte table: software path processes tails only
+static const uint32_t CRC32_NIBBLE_TABLE[16] =
+{
+  0x00000000U, 0x04C11DB7U, 0x09823B6EU, 0x0D4326D9U,
+  0x130476DCU, 0x17C56B6BU, 0x1A864DB2U, 0x1E475005U,
+  0x2608EDB8U, 0x22C9F00FU, 0x2F8AD6D6U, 0x2B4BCB61U,
+  0x350C9B64U, 0x31CD86D3U, 0x3C8EA00AU, 0x384FBDBDU
+};
+
+// interface for CRC calculating
+static CRC_HandleTypeDef * crc32_interface = 0;
+
+// access to the data register of the CRC unit, the host test replaces it
+// by a model of the unit
+#ifndef CRC32_UNIT_WRITE
+#define CRC32_UNIT_WRITE(word)  (crc32_interface->Instance->DR = (word))
+#define CRC32_UNIT_READ()       (crc32_interface->Instance->DR)
+#define CRC32_UNIT_RESET()      __HAL_CRC_DR_RESET(crc32_interface)
+#endif
+
+// the stream which runs in the CRC unit now
+static crc32_ctx_type * crc32_owner = 0;
+
+// crc32_init() was called
+static uint8_t crc32_ready = 0;
+
+/// @name crc32_sw_byte
+/// @brief The function adds one byte to the software CRC.
+/// @param crc current CRC value
+/// @param byte byte value
+/// @return new CRC value
+static uint32_t crc32_sw_byte(uint32_t crc, uint8_t byte)
+{
+  crc = (crc << 4) ^ CRC32_NIBBLE_TABLE[(crc >> 28) ^ (byte >> 4)];
+  crc = (crc << 4) ^ CRC32_NIBBLE_TABLE[(crc >> 28) ^ (byte & 0x0FU)];
+  return crc;
+}
+
+/// @name crc32_put_word
+/// @brief The function adds one word to the stream.
+/// @param ctx context of the stream
+/// @param word word, processed MSB first
+static void crc32_put_word(crc32_ctx_type * ctx, uint32_t word)
+{
+  if(ctx->in_unit)
+  {
+    CRC32_UNIT_WRITE(word);
+  }
+  else
+  {
+    ctx->crc = crc32_sw_byte(ctx->crc, (uint8_t)(word >> 24));
+    ctx->crc = crc32_sw_byte(ctx->crc, (uint8_t)(word >> 16));
+    ctx->crc = crc32_sw_byte(ctx->crc, (uint8_t)(word >> 8));
+    ctx->crc = crc32_sw_byte(ctx->crc, (uint8_t)word);
+  }
+}
+
+/// @name crc32_leave_unit
+/// @brief The function moves the stream from the CRC unit to software.
+/// @param ctx context of the stream
+static void crc32_leave_unit(crc32_ctx_type * ctx)
+{
+  if(ctx->in_unit)
+  {
+    ctx->crc = CRC32_UNIT_READ();
+    ctx->in_unit = 0;
+  }
+  if(crc32_owner == ctx)
+  {
+    crc32_owner = 0;
+  }
+}
+
+void crc32_init(CRC_HandleTypeDef * crc_interface)
+{
+  crc32_interface = crc_interface;
+  crc32_owner = 0;
+  crc32_ready = 1;
+}
+
+uint8_t crc32_is_ready(void)
+{
+  return crc32_ready;
+}
+
+void crc32_begin(crc32_ctx_type * ctx)
+{
+  ctx->crc = CRC32_INIT_VAL;
+  ctx->tail = 0;
+  ctx->tail_len = 0;
+  ctx->in_unit = 0;
+  if(crc32_interface != 0)
+  {
+    // the running stream continues in software
+    if(crc32_owner != 0)
+    {
+      crc32_leave_unit(crc32_owner);
+    }
+    CRC32_UNIT_RESET();
+    crc32_owner = ctx;
+    ctx->in_unit = 1;
+  }
+}
+
+void crc32_begin_sw(crc32_ctx_type * ctx)
+{
+  ctx->crc = CRC32_INIT_VAL;
+  ctx->tail = 0;
+  ctx->tail_len = 0;
+  ctx->in_unit = 0;
+}
+
+void crc32_update_words(crc32_ctx_type * ctx, const uint32_t * words, uint32_t num)
+{
+  // the stream is not word aligned
+  if(ctx->tail_len != 0U)
+  {
+    for(uint32_t i = 0; i < num; ++i)
+    {
+      uint8_t bytes[4] = {(uint8_t)(words[i] >> 24), (uint8_t)(words[i] >> 16),
+                          (uint8_t)(words[i] >> 8), (uint8_t)words[i]};
+      crc32_update_bytes(ctx, bytes, 4);
+    }
+  }
+  else if(ctx->in_unit)
+  {
+    for(uint32_t i = 0; i < num; ++i)
+    {
+      CRC32_UNIT_WRITE(words[i]);
+    }
+  }
+  else
+  {
+    for(uint32_t i = 0; i < num; ++i)
+    {
+      crc32_put_word(ctx, words[i]);
+    }
+  }
+}
+
+void crc32_update_bytes(crc32_ctx_type * ctx, const uint8_t * bytes, uint32_t len)
+{
+  // complete the word started by the previous call
+  while((ctx->tail_len != 0U) && (len != 0U))
+  {
+    ctx->tail = (ctx->tail << 8) | *bytes++;
+    --len;
+    if(++ctx->tail_len == 4U)
+    {
+      crc32_put_word(ctx, ctx->tail);
+      ctx->tail = 0;
+      ctx->tail_len = 0;
+    }
+  }
+  // whole words
+  for(; len >= 4U; len -= 4U, bytes += 4)
+  {
+    crc32_put_word(ctx, ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) |
+                        ((uint32_t)bytes[2] << 8) | bytes[3]);
+  }
+  // keep the rest for the next call
+  for(; len != 0U; --len)
+  {
+    ctx->tail = (ctx->tail << 8) | *bytes++;
+    ++ctx->tail_len;
+  }
+}
+
+uint32_t crc32_end(crc32_ctx_type * ctx)
+{
+  // a software stream leaves the state of the unit alone
+  if(ctx->in_unit)
+    crc32_leave_unit(ctx);
+  // finish the not aligned tail in software
+  for(uint8_t i = ctx->tail_len; i != 0U; --i)
+  {
+    ctx->crc = crc32_sw_byte(ctx->crc, (uint8_t)(ctx->tail >> (8U * (i - 1U))));
+  }
+  ctx->tail = 0;
+  ctx->tail_len = 0;
+  return ctx->crc;
+}
+
+uint32_t crc32_calc_words(const uint32_t * words, uint32_t num)
+{
+  crc32_ctx_type ctx;
+  crc32_begin(&ctx);
+  crc32_update_words(&ctx, words, num);
+  return crc32_end(&ctx);
+}
+
+uint32_t crc32_calc_bytes(const uint8_t * bytes, uint32_t len)
+{
+  crc32_ctx_type ctx;
+  crc32_begin(&ctx);
+  crc32_update_bytes(&ctx, bytes, len);
+  return crc32_end(&ctx);
+}
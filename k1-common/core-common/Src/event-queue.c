@@ -0,0 +1,79 @@
+/// *****************************************************************************
+/// @file           : event-queue.c
+/// @brief          : lock-free queue of events between interrupts and tasks
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "event-queue.h"
+
+// order of the accesses to the slot and the indices: Cortex-M3 has one core
+// and interrupts see its accesses in the program order, only the compiler
+// must not reorder them
+#define EVENT_QUEUE_BARRIER()   __ASM volatile ("" ::: "memory")
+
+EVENT_QUEUE_ERR_CODES event_queue_init(event_queue_type * queue, event_queue_event_type * buf, uint16_t size)
+{
+  if((buf == 0) || (size < 2U) || (size > 0x8000U) || ((size & (size - 1U)) != 0U))
+    return EVENT_QUEUE_ERR;
+  queue->buf = buf;
+  queue->mask = size - 1U;
+  queue->head = 0;
+  queue->tail = 0;
+  queue->max_used = 0;
+  queue->posted = 0;
+  queue->dropped = 0;
+  return EVENT_QUEUE_OK;
+}
+
+EVENT_QUEUE_ERR_CODES event_queue_post(event_queue_type * queue, uint16_t type, uint16_t arg, uint64_t time_us)
+{
+  uint16_t head = queue->head;
+  uint16_t used = (uint16_t)(head - queue->tail);
+  if(used > queue->mask)
+  {
+    ++queue->dropped;
+    return EVENT_QUEUE_ERR;
+  }
+  event_queue_event_type * event = &queue->buf[head & queue->mask];
+  event->time_us = time_us;
+  event->type = type;
+  event->arg = arg;
+  // the slot is written before the consumer sees it
+  EVENT_QUEUE_BARRIER();
+  queue->head = (uint16_t)(head + 1U);
+  ++used;
+  if(used > queue->max_used)
+    queue->max_used = used;
+  ++queue->posted;
+  return EVENT_QUEUE_OK;
+}
+
+uint8_t event_queue_get(event_queue_type * queue, event_queue_event_type * event)
+{
+  uint16_t tail = queue->tail;
+  if(tail == queue->head)
+    return 0U;
+  // head is read before the slot
+  EVENT_QUEUE_BARRIER();
+  *event = queue->buf[tail & queue->mask];
+  // the slot is read before the producer reuses it
+  EVENT_QUEUE_BARRIER();
+  queue->tail = (uint16_t)(tail + 1U);
+  return 1U;
+}
+
+uint16_t event_queue_count(const event_queue_type * queue)
+{
+  return (uint16_t)(queue->head - queue->tail);
+}
+
+void event_queue_get_stats(const event_queue_type * queue, event_queue_stats_type * stats)
+{
+  stats->posted = queue->posted;
+  stats->dropped = queue->dropped;
+  stats->max_used = queue->max_used;
+}
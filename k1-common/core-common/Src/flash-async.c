@@ -0,0 +1,331 @@
+/// *****************************************************************************
+/// @file           : flash-async.c
+/// @brief          : background flash erase/program service on FLASH interrupt
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "flash-async.h"
+
+// types of jobs
+enum
+{
+  FLASH_ASYNC_JOB_ERASE,
+  FLASH_ASYNC_JOB_PROGRAM,
+  FLASH_ASYNC_JOB_VERIFY
+};
+
+// result of the running operation, set by HAL callbacks
+enum
+{
+  FLASH_ASYNC_OP_NONE,
+  FLASH_ASYNC_OP_EOP,
+  FLASH_ASYNC_OP_ERR
+};
+
+// queued job
+typedef struct
+{
+  uint8_t type;
+  uint8_t res;                  // FLASH_ASYNC_ERR_CODES of the completed job
+  uint16_t num;                 // number of half-words
+  uint32_t addr;
+  const uint16_t * data;
+  flash_async_done_type done;
+  void * ctx;
+} flash_async_job_type;
+
+// jobs: queued at head, run at run, reported at tail
+static flash_async_job_type flash_async_queue[FLASH_ASYNC_QUEUE_SIZE];
+static volatile uint32_t flash_async_head = 0;
+static volatile uint32_t flash_async_run = 0;
+static volatile uint32_t flash_async_tail = 0;
+
+// half-words of the running job programmed
+static uint16_t flash_async_done_num = 0;
+// a flash operation is started
+static volatile uint8_t flash_async_running = 0;
+static volatile uint8_t flash_async_op = FLASH_ASYNC_OP_NONE;
+// erase jobs wait
+static volatile uint8_t flash_async_erase_held = 0;
+
+static flash_async_stats_type flash_async_stats = {0};
+
+/// @name flash_async_compare
+/// @brief The function compares flash with data.
+/// @param job the job with address and data
+/// @return FLASH_ASYNC_OK or FLASH_ASYNC_FLASH_ERR
+static uint8_t flash_async_compare(const flash_async_job_type * job)
+{
+  const uint16_t * cells = (const uint16_t *)job->addr;
+  for(uint16_t i = 0; i < job->num; ++i)
+  {
+    if(cells[i] != job->data[i])
+    {
+      ++flash_async_stats.verify_err;
+      return FLASH_ASYNC_FLASH_ERR;
+    }
+  }
+  return FLASH_ASYNC_OK;
+}
+
+/// @name flash_async_finish
+/// @brief The function completes the running job, it waits for the report.
+/// @param res FLASH_ASYNC_ERR_CODES of the job
+static void flash_async_finish(uint8_t res)
+{
+  flash_async_queue[flash_async_run & (FLASH_ASYNC_QUEUE_SIZE - 1U)].res = res;
+  flash_async_done_num = 0;
+  ++flash_async_stats.jobs;
+  ++flash_async_run;
+}
+
+/// @name flash_async_start
+/// @brief The function starts the operation of the next job. It runs with
+/// @brief FLASH interrupt masked or from it.
+static void flash_async_start(void)
+{
+  while(!flash_async_running && (flash_async_run != flash_async_head))
+  {
+    const flash_async_job_type * job = &flash_async_queue[flash_async_run & (FLASH_ASYNC_QUEUE_SIZE - 1U)];
+    if((job->type == FLASH_ASYNC_JOB_ERASE) && flash_async_erase_held)
+    {
+      ++flash_async_stats.erase_holds;
+      break;
+    }
+    HAL_StatusTypeDef status = HAL_OK;
+    switch(job->type)
+    {
+      case FLASH_ASYNC_JOB_ERASE:
+      {
+        FLASH_EraseInitTypeDef erase_str =
+        {
+          FLASH_TYPEERASE_PAGES,
+          FLASH_BANK_1, job->addr, 1
+        };
+        status = HAL_FLASHEx_Erase_IT(&erase_str);
+        break;
+      }
+
+      case FLASH_ASYNC_JOB_PROGRAM:
+        status = HAL_FLASH_Program_IT(FLASH_TYPEPROGRAM_HALFWORD, job->addr + 2U * flash_async_done_num,
+                                      job->data[flash_async_done_num]);
+        break;
+
+      default:
+        flash_async_finish(flash_async_compare(job));
+        continue;
+    }
+    if(status == HAL_OK)
+    {
+      flash_async_op = FLASH_ASYNC_OP_NONE;
+      flash_async_running = 1;
+    }
+    else
+    {
+      ++flash_async_stats.flash_err;
+      flash_async_finish(FLASH_ASYNC_FLASH_ERR);
+    }
+  }
+  if(!flash_async_running)
+    HAL_FLASH_Lock();
+}
+
+/// @name flash_async_process
+/// @brief The function takes the result of the finished operation and
+/// @brief starts the next one. It runs with FLASH interrupt masked or from it.
+static void flash_async_process(void)
+{
+  if(!flash_async_running || (flash_async_op == FLASH_ASYNC_OP_NONE))
+    return;
+  flash_async_running = 0;
+
+  const flash_async_job_type * job = &flash_async_queue[flash_async_run & (FLASH_ASYNC_QUEUE_SIZE - 1U)];
+  if(flash_async_op == FLASH_ASYNC_OP_ERR)
+  {
+    ++flash_async_stats.flash_err;
+    flash_async_finish(FLASH_ASYNC_FLASH_ERR);
+  }
+  else if(job->type == FLASH_ASYNC_JOB_ERASE)
+  {
+    ++flash_async_stats.erases;
+    flash_async_finish(FLASH_ASYNC_OK);
+  }
+  else
+  {
+    // read back the programmed half-word
+    uint32_t addr = job->addr + 2U * flash_async_done_num;
+    ++flash_async_stats.halfwords;
+    if(*(const uint16_t *)addr != job->data[flash_async_done_num])
+    {
+      ++flash_async_stats.verify_err;
+      flash_async_finish(FLASH_ASYNC_FLASH_ERR);
+    }
+    else if(++flash_async_done_num == job->num)
+    {
+      flash_async_finish(FLASH_ASYNC_OK);
+    }
+  }
+  flash_async_op = FLASH_ASYNC_OP_NONE;
+  flash_async_start();
+}
+
+/// @name flash_async_report
+/// @brief The function calls the callbacks of the completed jobs, outside
+/// @brief of the masked section.
+static void flash_async_report(void)
+{
+  while(1)
+  {
+    HAL_NVIC_DisableIRQ(FLASH_IRQn);
+    if(flash_async_tail == flash_async_run)
+    {
+      HAL_NVIC_EnableIRQ(FLASH_IRQn);
+      break;
+    }
+    flash_async_job_type job = flash_async_queue[flash_async_tail & (FLASH_ASYNC_QUEUE_SIZE - 1U)];
+    ++flash_async_tail;
+    HAL_NVIC_EnableIRQ(FLASH_IRQn);
+    if(job.done != 0)
+      job.done((FLASH_ASYNC_ERR_CODES)job.res, job.ctx);
+  }
+}
+
+/// @name flash_async_push
+/// @brief The function queues the job and starts it when the service is idle.
+/// @param job the job
+/// @return FLASH_ASYNC_OK or FLASH_ASYNC_BUSY
+static FLASH_ASYNC_ERR_CODES flash_async_push(const flash_async_job_type * job)
+{
+  FLASH_ASYNC_ERR_CODES ret_val = FLASH_ASYNC_BUSY;
+  HAL_NVIC_DisableIRQ(FLASH_IRQn);
+  if((flash_async_head - flash_async_tail) < FLASH_ASYNC_QUEUE_SIZE)
+  {
+    flash_async_queue[flash_async_head & (FLASH_ASYNC_QUEUE_SIZE - 1U)] = *job;
+    ++flash_async_head;
+    if(!flash_async_running)
+    {
+      HAL_FLASH_Unlock();
+      flash_async_start();
+    }
+    // jobs completed at once are reported from the interrupt
+    if(flash_async_tail != flash_async_run)
+      HAL_NVIC_SetPendingIRQ(FLASH_IRQn);
+    ret_val = FLASH_ASYNC_OK;
+  }
+  else
+  {
+    ++flash_async_stats.queue_full;
+  }
+  HAL_NVIC_EnableIRQ(FLASH_IRQn);
+  return ret_val;
+}
+
+void flash_async_init(void)
+{
+  flash_async_head = 0;
+  flash_async_run = 0;
+  flash_async_tail = 0;
+  flash_async_done_num = 0;
+  flash_async_running = 0;
+  flash_async_op = FLASH_ASYNC_OP_NONE;
+  flash_async_erase_held = 0;
+  HAL_NVIC_SetPriority(FLASH_IRQn, FLASH_ASYNC_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(FLASH_IRQn);
+}
+
+FLASH_ASYNC_ERR_CODES flash_async_erase(uint32_t addr, flash_async_done_type done, void * ctx)
+{
+  if((addr < FLASH_BASE) || (addr & (FLASH_PAGE_SIZE - 1U)))
+    return FLASH_ASYNC_ERR;
+  flash_async_job_type job = {FLASH_ASYNC_JOB_ERASE, FLASH_ASYNC_OK, 0, addr, 0, done, ctx};
+  return flash_async_push(&job);
+}
+
+FLASH_ASYNC_ERR_CODES flash_async_program(uint32_t addr, const uint16_t * data, uint16_t num,
+                                          flash_async_done_type done, void * ctx)
+{
+  if((addr < FLASH_BASE) || (addr & 1U) || (data == 0) || (num == 0U))
+    return FLASH_ASYNC_ERR;
+  flash_async_job_type job = {FLASH_ASYNC_JOB_PROGRAM, FLASH_ASYNC_OK, num, addr, data, done, ctx};
+  return flash_async_push(&job);
+}
+
+FLASH_ASYNC_ERR_CODES flash_async_verify(uint32_t addr, const uint16_t * data, uint16_t num,
+                                         flash_async_done_type done, void * ctx)
+{
+  if((addr < FLASH_BASE) || (addr & 1U) || (data == 0) || (num == 0U))
+    return FLASH_ASYNC_ERR;
+  flash_async_job_type job = {FLASH_ASYNC_JOB_VERIFY, FLASH_ASYNC_OK, num, addr, data, done, ctx};
+  return flash_async_push(&job);
+}
+
+uint8_t flash_async_is_busy(void)
+{
+  return (flash_async_tail != flash_async_head) ? 1U : 0U;
+}
+
+void flash_async_hold_erase(uint8_t hold)
+{
+  HAL_NVIC_DisableIRQ(FLASH_IRQn);
+  flash_async_erase_held = hold ? 1U : 0U;
+  if(!hold && !flash_async_running && (flash_async_run != flash_async_head))
+  {
+    HAL_FLASH_Unlock();
+    flash_async_start();
+    if(flash_async_tail != flash_async_run)
+      HAL_NVIC_SetPendingIRQ(FLASH_IRQn);
+  }
+  HAL_NVIC_EnableIRQ(FLASH_IRQn);
+}
+
+uint8_t flash_async_is_erase_held(void)
+{
+  uint8_t ret_val = 0;
+  HAL_NVIC_DisableIRQ(FLASH_IRQn);
+  if(flash_async_erase_held && !flash_async_running && (flash_async_run != flash_async_head) &&
+     (flash_async_queue[flash_async_run & (FLASH_ASYNC_QUEUE_SIZE - 1U)].type == FLASH_ASYNC_JOB_ERASE))
+  {
+    ret_val = 1U;
+  }
+  HAL_NVIC_EnableIRQ(FLASH_IRQn);
+  return ret_val;
+}
+
+void flash_async_poll(void)
+{
+  HAL_NVIC_DisableIRQ(FLASH_IRQn);
+  if(flash_async_running)
+    HAL_FLASH_IRQHandler();
+  flash_async_process();
+  HAL_NVIC_EnableIRQ(FLASH_IRQn);
+  flash_async_report();
+}
+
+void flash_async_get_stats(flash_async_stats_type * stats)
+{
+  *stats = flash_async_stats;
+}
+
+void flash_async_isr(void)
+{
+  flash_async_process();
+  flash_async_report();
+}
+
+/// HAL callback: the operation is complete
+void HAL_FLASH_EndOfOperationCallback(uint32_t ReturnValue)
+{
+  (void)ReturnValue;
+  flash_async_op = FLASH_ASYNC_OP_EOP;
+}
+
+/// HAL callback: the operation failed
+void HAL_FLASH_OperationErrorCallback(uint32_t ReturnValue)
+{
+  (void)ReturnValue;
+  flash_async_op = FLASH_ASYNC_OP_ERR;
+}
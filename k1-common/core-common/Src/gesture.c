@@ -0,0 +1,238 @@
+/// *****************************************************************************
+/// @file           : gesture.c
+/// @brief          : recognizer of button gestures
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "gesture.h"
+#include "time-base.h"
+
+// sequence of the button in progress
+typedef struct
+{
+  uint8_t seq[GESTURE_SEQ_MAX]; // elements so far
+  uint8_t len;                  // number of the elements, 0 - idle
+  uint8_t pushed;               // 1 - the button is pushed
+  uint8_t hold;                 // 1 - the push is a hold
+  uint8_t repeats;              // reports of the hold
+  const gesture_type * match;   // hold gesture in progress
+  uint64_t start_us;            // first push of the sequence
+  uint64_t push_us;             // the last push
+  uint64_t due_us;              // time of the hold or the gap, 0 - none
+} gesture_state_type;
+
+static const gesture_config_type * gesture_config = 0;
+static uint8_t gesture_inputs_num = 0;
+static gesture_state_type gesture_state[GESTURE_INPUTS_MAX];
+
+// queue of the gestures
+static event_queue_event_type gesture_events_buf[GESTURE_EVENTS_SIZE];
+static event_queue_type gesture_events;
+
+/// @name gesture_find
+/// @brief The function looks for the sequence in the table of the button.
+/// @param input number of the button
+/// @param prefix pointer to store 1 if a longer gesture starts with the
+/// @param        sequence
+/// @return the gesture or 0 - no such gesture
+static const gesture_type * gesture_find(uint8_t input, uint8_t * prefix)
+{
+  const gesture_config_type * config = &gesture_config[input];
+  const gesture_state_type * st = &gesture_state[input];
+  const gesture_type * ret_val = 0;
+  *prefix = 0;
+  for(uint8_t g = 0; g < config->gestures_num; ++g)
+  {
+    const gesture_type * gesture = &config->gestures[g];
+    uint8_t i = 0;
+    while((i < st->len) && (gesture->seq[i] == st->seq[i]))
+      ++i;
+    if(i < st->len)
+      continue;
+    if((i == GESTURE_SEQ_MAX) || (gesture->seq[i] == GESTURE_END))
+      ret_val = gesture;
+    else
+      *prefix = 1U;
+  }
+  return ret_val;
+}
+
+/// @name gesture_report
+/// @brief The function queues the recognized gesture.
+/// @param input number of the button
+/// @param gesture recognized gesture
+static void gesture_report(uint8_t input, const gesture_type * gesture)
+{
+  gesture_state_type * st = &gesture_state[input];
+  uint16_t arg = (uint16_t)(input | ((uint16_t)st->repeats << 8));
+  event_queue_post(&gesture_events, gesture->id, arg, st->start_us);
+  if(st->repeats < UINT8_MAX)
+    ++st->repeats;
+}
+
+/// @name gesture_reset
+/// @brief The function ends the sequence of the button.
+/// @param input number of the button
+static void gesture_reset(uint8_t input)
+{
+  gesture_state_type * st = &gesture_state[input];
+  st->len = 0;
+  st->hold = 0;
+  st->repeats = 0;
+  st->match = 0;
+  st->due_us = 0;
+}
+
+/// @name gesture_timeout
+/// @brief The function processes the hold, its repeat or the gap.
+/// @param input number of the button
+static void gesture_timeout(uint8_t input)
+{
+  const gesture_config_type * config = &gesture_config[input];
+  gesture_state_type * st = &gesture_state[input];
+  uint8_t prefix;
+
+  // repeat of the hold
+  if(st->match != 0)
+  {
+    gesture_report(input, st->match);
+    st->due_us += st->match->repeat_ms * 1000ULL;
+    return;
+  }
+  // the push is a hold, it ends the sequence
+  if(st->pushed)
+  {
+    st->hold = 1U;
+    st->seq[st->len++] = GESTURE_HOLD;
+    const gesture_type * gesture = gesture_find(input, &prefix);
+    st->due_us = 0;
+    if(gesture != 0)
+    {
+      gesture_report(input, gesture);
+      if(gesture->repeat_ms != 0U)
+      {
+        st->match = gesture;
+        st->due_us = st->push_us + (config->hold_ms + gesture->repeat_ms) * 1000ULL;
+      }
+    }
+    return;
+  }
+  // no click in the gap
+  const gesture_type * gesture = gesture_find(input, &prefix);
+  if(gesture != 0)
+    gesture_report(input, gesture);
+  gesture_reset(input);
+}
+
+GESTURE_ERR_CODES gesture_init(const gesture_config_type * config, uint8_t num)
+{
+  if(num > GESTURE_INPUTS_MAX)
+    return GESTURE_ERR;
+  // a hold is the last element
+  for(uint8_t b = 0; b < num; ++b)
+  {
+    for(uint8_t g = 0; g < config[b].gestures_num; ++g)
+    {
+      const uint8_t * seq = config[b].gestures[g].seq;
+      if(seq[0] == GESTURE_END)
+        return GESTURE_ERR;
+      for(uint8_t i = 0; (i + 1U) < GESTURE_SEQ_MAX; ++i)
+      {
+        if((seq[i] == GESTURE_HOLD) && (seq[i + 1U] != GESTURE_END))
+          return GESTURE_ERR;
+      }
+    }
+  }
+  gesture_config = config;
+  gesture_inputs_num = num;
+  for(uint8_t b = 0; b < num; ++b)
+  {
+    gesture_state[b].pushed = 0;
+    gesture_reset(b);
+  }
+  return (event_queue_init(&gesture_events, gesture_events_buf, GESTURE_EVENTS_SIZE) == EVENT_QUEUE_OK) ? GESTURE_OK : GESTURE_ERR;
+}
+
+void gesture_input(const event_queue_event_type * event)
+{
+  uint8_t input = (uint8_t)event->arg;
+  if((input >= gesture_inputs_num) || (gesture_config[input].gestures_num == 0U))
+    return;
+  const gesture_config_type * config = &gesture_config[input];
+  gesture_state_type * st = &gesture_state[input];
+  uint8_t prefix;
+
+  // the hold or the gap has passed before the event
+  while((st->due_us != 0U) && (event->time_us >= st->due_us))
+    gesture_timeout(input);
+
+  if(event->type == BUTTONS_EV_PUSH)
+  {
+    // the sequence is full or ended by the hold
+    if((st->len == GESTURE_SEQ_MAX) || st->hold)
+      gesture_reset(input);
+    if(st->len == 0U)
+      st->start_us = event->time_us;
+    st->pushed = 1U;
+    st->push_us = event->time_us;
+    st->due_us = event->time_us + config->hold_ms * 1000ULL;
+  }
+  else if(event->type == BUTTONS_EV_RELEASE)
+  {
+    // a push before the start
+    if(!st->pushed)
+      return;
+    st->pushed = 0;
+    if(st->hold)
+    {
+      gesture_reset(input);
+      return;
+    }
+    st->seq[st->len++] = GESTURE_CLICK;
+    const gesture_type * gesture = gesture_find(input, &prefix);
+    // no longer gesture: no wait for the gap
+    if(!prefix || (st->len == GESTURE_SEQ_MAX))
+    {
+      if(gesture != 0)
+        gesture_report(input, gesture);
+      gesture_reset(input);
+    }
+    else
+    {
+      st->due_us = event->time_us + config->gap_ms * 1000ULL;
+    }
+  }
+}
+
+void gesture_handler(void)
+{
+  uint64_t now_us = time_base_us();
+  for(uint8_t b = 0; b < gesture_inputs_num; ++b)
+  {
+    while((gesture_state[b].due_us != 0U) && (now_us >= gesture_state[b].due_us))
+      gesture_timeout(b);
+  }
+}
+
+uint32_t gesture_get_next_ms(void)
+{
+  uint64_t next_us = UINT64_MAX;
+  for(uint8_t b = 0; b < gesture_inputs_num; ++b)
+  {
+    if((gesture_state[b].due_us != 0U) && (gesture_state[b].due_us < next_us))
+      next_us = gesture_state[b].due_us;
+  }
+  if(next_us == UINT64_MAX)
+    return 0U;
+  uint64_t now_us = time_base_us();
+  return (next_us > now_us) ? (uint32_t)((next_us - now_us + 999U) / 1000U) : 1U;
+}
+
+uint8_t gesture_get(event_queue_event_type * event)
+{
+  return event_queue_get(&gesture_events, event);
+}
@@ -0,0 +1,199 @@
+/// *****************************************************************************
+/// @file           : item-state.c
+/// @brief          : state of k1 bus address management
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "item-state.h"
+#include "time-base.h"
+
+// conditions of the item, the state is derived from them
+#define ITEM_COND_DEFINED     0x01U // the item has got its first condition
+#define ITEM_COND_ATTENTION   0x02U
+#define ITEM_COND_FIRE        0x04U // latched till the reset
+#define ITEM_COND_LINK_LOST   0x08U
+#define ITEM_COND_NO_ADDRESS  0x10U
+#define ITEM_COND_DUPLICATE   0x20U
+#define ITEM_COND_SERVICE     0x40U
+#define ITEM_COND_TEST        0x80U
+
+// conditions set and cleared by the event
+typedef struct
+{
+  uint8_t set;
+  uint8_t clear;
+} item_state_event_cond_type;
+
+static const item_state_event_cond_type ITEM_STATE_EVENTS[ITEM_EV_AMOUNT] =
+{
+  //                        set                                       clear
+  [ITEM_EV_NORM] =         {ITEM_COND_DEFINED,                        ITEM_COND_ATTENTION},
+  [ITEM_EV_ATTENTION] =    {ITEM_COND_DEFINED | ITEM_COND_ATTENTION,  0U},
+  [ITEM_EV_FIRE] =         {ITEM_COND_DEFINED | ITEM_COND_FIRE,       0U},
+  [ITEM_EV_RESET] =        {0U,                                       ITEM_COND_ATTENTION | ITEM_COND_FIRE},
+  [ITEM_EV_LINK_LOST] =    {ITEM_COND_DEFINED | ITEM_COND_LINK_LOST,  0U},
+  [ITEM_EV_LINK_OK] =      {0U,                                       ITEM_COND_LINK_LOST},
+  [ITEM_EV_ADDR_NONE] =    {ITEM_COND_DEFINED | ITEM_COND_NO_ADDRESS, 0U},
+  [ITEM_EV_ADDR_SET] =     {ITEM_COND_DEFINED,                        ITEM_COND_NO_ADDRESS | ITEM_COND_DUPLICATE},
+  [ITEM_EV_DUPLICATE] =    {ITEM_COND_DEFINED | ITEM_COND_DUPLICATE,  0U},
+  [ITEM_EV_SERVICE] =      {ITEM_COND_SERVICE,                        0U},
+  [ITEM_EV_SERVICE_DONE] = {0U,                                       ITEM_COND_SERVICE},
+  [ITEM_EV_TEST_ON] =      {ITEM_COND_TEST,                           0U},
+  [ITEM_EV_TEST_OFF] =     {0U,                                       ITEM_COND_TEST},
+};
+
+// state of the condition by priority, the first present condition wins
+typedef struct
+{
+  uint8_t cond;
+  ITEM_STATE_TYPE state;
+} item_state_priority_type;
+
+static const item_state_priority_type ITEM_STATE_PRIORITY[] =
+{
+  {ITEM_COND_FIRE,        ITEM_STATE_FIRE},
+  {ITEM_COND_ATTENTION,   ITEM_STATE_ATTENTION},
+  {ITEM_COND_NO_ADDRESS,  ITEM_STATE_NO_ADDRESS},
+  {ITEM_COND_DUPLICATE,   ITEM_STATE_DUPLICATE},
+  {ITEM_COND_LINK_LOST,   ITEM_STATE_LINK_LOST},
+  {ITEM_COND_TEST,        ITEM_STATE_TEST},
+  {ITEM_COND_SERVICE,     ITEM_STATE_SERVICE},
+};
+#define ITEM_STATE_PRIORITY_NUM   (sizeof(ITEM_STATE_PRIORITY) / sizeof(ITEM_STATE_PRIORITY[0]))
+
+// items of the device
+typedef struct
+{
+  item_state_record_type record;
+  uint8_t cond;               // ITEM_COND_xxx
+  uint64_t first_edge_us;     // edge of the first change not armed
+  uint64_t armed_edge_us;     // edge of the first change armed, not sent
+  uint8_t changed;            // the state is not in the armed reply
+  uint8_t armed;              // the armed reply carries a change
+} item_state_item_type;
+
+static item_state_item_type item_state_items[K1_NUM_OF_ITEMS];
+static item_state_stats_type item_state_stats = {0};
+
+/// @name item_state_derive
+/// @brief The function gives the state of the conditions.
+/// @param cond ITEM_COND_xxx
+/// @return state of the highest priority condition
+static ITEM_STATE_TYPE item_state_derive(uint8_t cond)
+{
+  if(!(cond & ITEM_COND_DEFINED))
+    return ITEM_STATE_UNDEFINED;
+  for(uint8_t i = 0; i < ITEM_STATE_PRIORITY_NUM; ++i)
+  {
+    if(cond & ITEM_STATE_PRIORITY[i].cond)
+      return ITEM_STATE_PRIORITY[i].state;
+  }
+  return ITEM_STATE_NORM;
+}
+
+/// @name item_state_change
+/// @brief The function stamps the transition of the item.
+/// @param item item's number
+/// @param state new state
+/// @param event event of the transition
+/// @param edge_us input edge of the event
+static void item_state_change(uint8_t item, ITEM_STATE_TYPE state, ITEM_EVENT_TYPE event, uint64_t edge_us)
+{
+  item_state_item_type * it = &item_state_items[item];
+  it->record.prev = it->record.state;
+  it->record.state = state;
+  it->record.event = event;
+  it->record.edge_us = edge_us;
+  it->record.change_us = time_base_us();
+  it->record.publish_us = 0;
+  // the latency counts from the first change not armed yet
+  if(!it->changed)
+    it->first_edge_us = edge_us;
+  it->changed = 1U;
+  ++item_state_stats.transitions;
+}
+
+void item_state_init(void)
+{
+  for(uint8_t i = 0; i < K1_NUM_OF_ITEMS; ++i)
+  {
+    item_state_record_type record = {ITEM_STATE_UNDEFINED, ITEM_STATE_UNDEFINED, ITEM_EV_NORM, 0, 0, 0};
+    item_state_items[i].record = record;
+    item_state_items[i].cond = 0;
+    item_state_items[i].first_edge_us = 0;
+    item_state_items[i].armed_edge_us = 0;
+    item_state_items[i].changed = 0;
+    item_state_items[i].armed = 0;
+  }
+}
+
+ITEM_STATE_TYPE item_state_event(uint8_t item, ITEM_EVENT_TYPE event, uint64_t edge_us)
+{
+  if((item >= K1_NUM_OF_ITEMS) || (event >= ITEM_EV_AMOUNT))
+    return ITEM_STATE_UNDEFINED;
+  item_state_item_type * it = &item_state_items[item];
+  it->cond = (uint8_t)((it->cond & ~ITEM_STATE_EVENTS[event].clear) | ITEM_STATE_EVENTS[event].set);
+  ITEM_STATE_TYPE next = item_state_derive(it->cond);
+  if(next == it->record.state)
+    ++item_state_stats.ignored;
+  else
+    item_state_change(item, next, event, edge_us);
+  return next;
+}
+
+void item_state_set(ITEM_STATE_TYPE state, uint8_t item)
+{
+  if((item < K1_NUM_OF_ITEMS) && (state <= ITEM_STATE_MAX) && (state != item_state_items[item].record.state))
+    item_state_change(item, state, item_state_items[item].record.event, time_base_us());
+}
+
+ITEM_STATE_TYPE item_state_get(uint8_t item)
+{
+  return (item < K1_NUM_OF_ITEMS) ? item_state_items[item].record.state : ITEM_STATE_UNDEFINED;
+}
+
+uint8_t item_state_is_changed(uint8_t item)
+{
+  return (item < K1_NUM_OF_ITEMS) ? item_state_items[item].changed : 0U;
+}
+
+void item_state_armed(uint8_t item)
+{
+  if((item >= K1_NUM_OF_ITEMS) || !item_state_items[item].changed)
+    return;
+  item_state_item_type * it = &item_state_items[item];
+  // a change armed before and not sent yet keeps its edge
+  if(!it->armed)
+    it->armed_edge_us = it->first_edge_us;
+  it->armed = 1U;
+  it->changed = 0;
+}
+
+void item_state_published(uint8_t item, uint64_t publish_us)
+{
+  if((item >= K1_NUM_OF_ITEMS) || !item_state_items[item].armed)
+    return;
+  item_state_item_type * it = &item_state_items[item];
+  it->armed = 0;
+  it->record.publish_us = publish_us;
+  uint64_t latency = (publish_us > it->armed_edge_us) ? (publish_us - it->armed_edge_us) : 0U;
+  item_state_stats.last_us = (latency > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency;
+  if(item_state_stats.last_us > item_state_stats.max_us)
+    item_state_stats.max_us = item_state_stats.last_us;
+  ++item_state_stats.published;
+}
+
+void item_state_get_record(uint8_t item, item_state_record_type * record)
+{
+  if(item < K1_NUM_OF_ITEMS)
+    *record = item_state_items[item].record;
+}
+
+void item_state_get_stats(item_state_stats_type * stats)
+{
+  *stats = item_state_stats;
+}
@@ -14,6 +14,10 @@
 
 /// K1 addresses of all items in our device
 static uint8_t k1_addr[K1_NUM_OF_ITEMS] = {0};
+/// map of the own addresses, bit (addr & 31) of word (addr >> 5)
+static volatile uint32_t k1_addr_map[256U / 32U] = {0};
+/// items by address, item + 1, 0 - no item
+static volatile uint8_t k1_addr_items[256U] = {0};
 
 K1_ADDR_ERR_CODES k1_addr_set(uint8_t addr, uint8_t item)
 {
@@ -24,8 +28,26 @@ K1_ADDR_ERR_CODES k1_addr_set(uint8_t addr, uint8_t item)
 		// correctness of address
 		if(addr > 0U)
 		{
-			// set address
-			k1_addr[item] = addr;
+			uint8_t owner = k1_addr_items[addr];
+			uint8_t old = k1_addr[item];
+			// one item per address
+			if((owner != 0U) && (owner != (uint8_t)(item + 1U)))
+			{
+				ret_val = K1_ADDR_ERR;
+			}
+			else if(old != addr)
+			{
+				// interrupts see the old address or the new one, not other item
+				if(old != 0U)
+				{
+					k1_addr_map[old >> 5] &= ~(1UL << (old & 31U));
+					k1_addr_items[old] = 0;
+				}
+				// set address
+				k1_addr[item] = addr;
+				k1_addr_items[addr] = (uint8_t)(item + 1U);
+				k1_addr_map[addr >> 5] |= 1UL << (addr & 31U);
+			}
 		}
 	}
 	else
@@ -51,5 +73,12 @@ uint8_t k1_addr_get(uint8_t item)
 	}
 }
 
+uint8_t k1_addr_is_own(uint8_t addr)
+{
+	return (k1_addr_map[addr >> 5] >> (addr & 31U)) & 1U;
+}
 
-
+uint8_t k1_addr_get_item(uint8_t addr)
+{
+	return (uint8_t)(k1_addr_items[addr] - 1U);
+}
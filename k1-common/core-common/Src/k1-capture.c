@@ -0,0 +1,239 @@
+/// *****************************************************************************
+/// @file           : k1-capture.c
+/// @brief          : k1 line pulse decoder (TIM4 input capture + DMA)
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "k1-capture.h"
+
+// one captured symbol, the layout of the DMA burst (CCR1, CCR2)
+typedef struct
+{
+  uint16_t period;  // CCR1: period of the previous symbol
+  uint16_t width;   // CCR2: pulse width of this symbol
+} k1_cap_edge_type;
+
+// timer of k1_capture input
+static TIM_HandleTypeDef * k1_cap_tim = 0;
+
+// capture buffer length, one spare symbol tells a too long frame
+#define K1_CAP_BUF_LEN  (K1_CAP_SYMBOLS_MAX + 1U)
+
+// double capture buffer: DMA fills one, the main loop decodes the other
+static k1_cap_edge_type k1_cap_buf[2][K1_CAP_BUF_LEN];
+// buffer filled by DMA
+static uint8_t k1_cap_active = 0;
+// number of symbols in the other buffer, 0 - decoded by the main loop
+static volatile uint16_t k1_cap_ready_len = 0;
+
+// timing table
+static k1_cap_timing_type k1_cap_timing =
+{
+  .glitch_us = K1_PHY_GLITCH_US,
+  .period = {K1_PHY_BIT_PERIOD_US - K1_PHY_TOLERANCE_US, K1_PHY_BIT_PERIOD_US + K1_PHY_TOLERANCE_US},
+  .symbol =
+  {
+    [K1_CAP_SYMBOL_BIT0] = {K1_PHY_BIT0_PULSE_US - K1_PHY_TOLERANCE_US, K1_PHY_BIT0_PULSE_US + K1_PHY_TOLERANCE_US},
+    [K1_CAP_SYMBOL_BIT1] = {K1_PHY_BIT1_PULSE_US - K1_PHY_TOLERANCE_US, K1_PHY_BIT1_PULSE_US + K1_PHY_TOLERANCE_US},
+    [K1_CAP_SYMBOL_SYNC] = {K1_PHY_SYNC_PULSE_US - K1_PHY_TOLERANCE_US, K1_PHY_SYNC_PULSE_US + K1_PHY_TOLERANCE_US},
+  },
+};
+
+// counters
+static k1_cap_stats_type k1_cap_stats = {0};
+
+/// @name k1_cap_dma_start
+/// @brief The function starts DMA burst reads of CCR1 and CCR2 on CH2
+/// @brief capture into the active buffer.
+/// @return K1_CAP_OK or K1_CAP_ERR
+static K1_CAP_ERR_CODES k1_cap_dma_start(void)
+{
+  K1_CAP_ERR_CODES ret_val = K1_CAP_ERR;
+  if(HAL_DMA_Start(k1_cap_tim->hdma[TIM_DMA_ID_CC2], (uint32_t)&k1_cap_tim->Instance->DMAR,
+                   (uint32_t)k1_cap_buf[k1_cap_active], 2U * K1_CAP_BUF_LEN) == HAL_OK)
+  {
+    ret_val = K1_CAP_OK;
+  }
+  return ret_val;
+}
+
+/// @name k1_cap_symbol
+/// @brief The function classifies the pulse width by the timing table.
+/// @param width pulse width, us
+/// @return K1_CAP_SYMBOL_xxx or K1_CAP_SYMBOLS_AMOUNT if out of spec
+static uint8_t k1_cap_symbol(uint16_t width)
+{
+  for(uint8_t i = 0; i < K1_CAP_SYMBOLS_AMOUNT; ++i)
+  {
+    if((width >= k1_cap_timing.symbol[i].min_us) && (width <= k1_cap_timing.symbol[i].max_us))
+      return i;
+  }
+  return K1_CAP_SYMBOLS_AMOUNT;
+}
+
+K1_CAP_ERR_CODES k1_cap_init(TIM_HandleTypeDef * tim)
+{
+  K1_CAP_ERR_CODES ret_val = K1_CAP_ERR;
+  if((tim != 0) && (tim->hdma[TIM_DMA_ID_CC2] != 0))
+  {
+    k1_cap_tim = tim;
+    k1_cap_active = 0;
+    k1_cap_ready_len = 0;
+
+    // only the overflow makes the update event, not the reset by the edge
+    tim->Instance->CR1 |= TIM_CR1_URS;
+    // CH2 capture reads CCR1 and CCR2 by one DMA burst
+    tim->Instance->DCR = TIM_DMABASE_CCR1 | TIM_DMABURSTLENGTH_2TRANSFERS;
+
+    if((k1_cap_dma_start() == K1_CAP_OK) &&
+       (HAL_TIM_IC_Start(tim, TIM_CHANNEL_1) == HAL_OK) &&
+       (HAL_TIM_IC_Start(tim, TIM_CHANNEL_2) == HAL_OK))
+    {
+      __HAL_TIM_ENABLE_DMA(tim, TIM_DMA_CC2);
+      // wait for the first edge of a frame
+      __HAL_TIM_CLEAR_IT(tim, TIM_IT_CC1);
+      __HAL_TIM_ENABLE_IT(tim, TIM_IT_CC1);
+      ret_val = K1_CAP_OK;
+    }
+  }
+  return ret_val;
+}
+
+void k1_cap_set_timing(const k1_cap_timing_type * timing)
+{
+  k1_cap_timing = *timing;
+}
+
+uint8_t k1_cap_frame_get(uint8_t * buf, uint8_t size)
+{
+  uint16_t len = k1_cap_ready_len;
+  if(len == 0U)
+    return 0U;
+
+  const k1_cap_edge_type * edge = k1_cap_buf[k1_cap_active ^ 1U];
+  uint8_t ret_val = 0;
+  uint8_t glitches = 0;
+  uint8_t error = 0;
+  uint16_t symbols = 0;
+  // the edge of a glitch has reset the counter: its period is a part of the
+  // period of the next edge
+  uint32_t glitch_us = 0;
+
+  for(uint16_t i = 0; i < len; ++i)
+  {
+    if(edge[i].width < k1_cap_timing.glitch_us)
+    {
+      ++glitches;
+      glitch_us += edge[i].period;
+      continue;
+    }
+    // the period of the previous symbol ends at this edge
+    uint32_t period = edge[i].period + glitch_us;
+    glitch_us = 0;
+    if((symbols > 0U) &&
+       ((period < k1_cap_timing.period.min_us) || (period > k1_cap_timing.period.max_us)))
+    {
+      ++k1_cap_stats.out_of_spec;
+      error = 1U;
+      break;
+    }
+    uint8_t symbol = k1_cap_symbol(edge[i].width);
+    if(symbol == K1_CAP_SYMBOLS_AMOUNT)
+    {
+      ++k1_cap_stats.out_of_spec;
+      error = 1U;
+      break;
+    }
+    // SYNC starts the frame, then bits follow MSB first
+    if((symbols == 0U) != (symbol == K1_CAP_SYMBOL_SYNC))
+    {
+      error = 1U;
+      break;
+    }
+    if(symbols > 0U)
+    {
+      uint16_t bit = symbols - 1U;
+      if((bit >> 3) >= size)
+      {
+        error = 1U;
+        break;
+      }
+      if((bit & 7U) == 0U)
+        buf[bit >> 3] = 0;
+      if(symbol == K1_CAP_SYMBOL_BIT1)
+        buf[bit >> 3] |= (uint8_t)(0x80U >> (bit & 7U));
+    }
+    ++symbols;
+  }
+
+  k1_cap_stats.glitches += glitches;
+  if(symbols > 0U)
+  {
+    // whole bytes only
+    if((error == 0U) && (((symbols - 1U) & 7U) == 0U) && (symbols > 1U))
+    {
+      ret_val = (uint8_t)((symbols - 1U) >> 3);
+      ++k1_cap_stats.frames;
+    }
+    else
+    {
+      ++k1_cap_stats.bad_frames;
+    }
+  }
+  else if(error)
+  {
+    ++k1_cap_stats.bad_frames;
+  }
+
+  // the buffer is free for the next frame
+  k1_cap_ready_len = 0;
+  return ret_val;
+}
+
+void k1_cap_get_stats(k1_cap_stats_type * stats)
+{
+  *stats = k1_cap_stats;
+}
+
+void k1_cap_frame_end_isr(void)
+{
+  DMA_HandleTypeDef * dma = k1_cap_tim->hdma[TIM_DMA_ID_CC2];
+  uint16_t len = (uint16_t)((2U * K1_CAP_BUF_LEN - __HAL_DMA_GET_COUNTER(dma)) / 2U);
+  HAL_DMA_Abort(dma);
+
+  if(len > K1_CAP_SYMBOLS_MAX)
+  {
+    // the frame does not fit the buffer, the rest of it is lost
+    ++k1_cap_stats.too_long;
+  }
+  else if(len > 0U)
+  {
+    if(k1_cap_ready_len != 0U)
+    {
+      ++k1_cap_stats.overflow;
+    }
+    else
+    {
+      k1_cap_ready_len = len;
+      k1_cap_active ^= 1U;
+    }
+  }
+  k1_cap_dma_start();
+
+  // the line is quiet: sleep till the first edge of the next frame
+  __HAL_TIM_DISABLE_IT(k1_cap_tim, TIM_IT_UPDATE);
+  __HAL_TIM_CLEAR_IT(k1_cap_tim, TIM_IT_CC1);
+  __HAL_TIM_ENABLE_IT(k1_cap_tim, TIM_IT_CC1);
+}
+
+void k1_cap_frame_start_isr(void)
+{
+  // the edge has reset the counter, its overflow is the frame end
+  __HAL_TIM_DISABLE_IT(k1_cap_tim, TIM_IT_CC1);
+  __HAL_TIM_CLEAR_IT(k1_cap_tim, TIM_IT_UPDATE);
+  __HAL_TIM_ENABLE_IT(k1_cap_tim, TIM_IT_UPDATE);
+}
@@ -0,0 +1,225 @@
+/// *****************************************************************************
+/// @file           : k1-dup.c
+/// @brief          : detector of duplicate k1 bus addresses
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "k1-dup.h"
+#include "k1-addr.h"
+#include "k1-frame.h"
+#include "item-state.h"
+#include "time-base.h"
+
+// items of the device
+typedef struct
+{
+  k1_dup_state_type state;
+  uint8_t polls_left;           // POLLs of the back-off
+  uint8_t lost;                 // lost echoes in a row
+} k1_dup_item_type;
+
+static k1_dup_item_type k1_dup_items[K1_NUM_OF_ITEMS];
+static k1_dup_stats_type k1_dup_stats = {0};
+static k1_dup_handler_type k1_dup_confirmed_handler = 0;
+static uint32_t k1_dup_random = 1U;
+
+// the reply waiting for its echo
+static k1_tx_last_type k1_dup_sent = {0};
+static uint64_t k1_dup_echo_deadline_ms = 0;
+static uint8_t k1_dup_echo_pending = 0;
+
+/// @name k1_dup_next_random
+/// @brief The function steps the xorshift generator.
+/// @return random number
+static uint32_t k1_dup_next_random(void)
+{
+  uint32_t x = k1_dup_random;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  k1_dup_random = x;
+  return x;
+}
+
+/// @name k1_dup_is_alarm
+/// @brief The function tells the item reports an alarm, it must not keep
+/// @brief silent.
+/// @param item item's number
+/// @return 1 - FIRE or ATTENTION
+static uint8_t k1_dup_is_alarm(uint8_t item)
+{
+  ITEM_STATE_TYPE state = item_state_get(item);
+  return ((state == ITEM_STATE_FIRE) || (state == ITEM_STATE_ATTENTION)) ? 1U : 0U;
+}
+
+/// @name k1_dup_backoff
+/// @brief The function starts the back-off of the item or confirms the
+/// @brief duplicate when the item is already silent.
+/// @param item item's number
+static void k1_dup_backoff(uint8_t item)
+{
+  k1_dup_item_type * it = &k1_dup_items[item];
+  it->lost = 0;
+  if(it->state == K1_DUP_NORM)
+  {
+    if(k1_dup_is_alarm(item))
+    {
+      ++k1_dup_stats.alarm_holds;
+      return;
+    }
+    it->state = K1_DUP_BACKOFF;
+    it->polls_left = (uint8_t)(1U + (k1_dup_next_random() % K1_DUP_BACKOFF_MAX));
+    k1_tx_disarm(item);
+  }
+  else if(it->state == K1_DUP_BACKOFF)
+  {
+    it->state = K1_DUP_CONFIRMED;
+    ++k1_dup_stats.confirmed;
+    if(k1_dup_confirmed_handler != 0)
+      k1_dup_confirmed_handler(item);
+  }
+}
+
+/// @name k1_dup_lost
+/// @brief The function counts the lost or corrupt echo of the item, a row
+/// @brief of them starts the back-off.
+/// @param item item's number
+static void k1_dup_lost(uint8_t item)
+{
+  ++k1_dup_stats.lost;
+  // a lost echo never confirms the duplicate
+  if((item >= K1_NUM_OF_ITEMS) || (k1_dup_items[item].state != K1_DUP_NORM))
+    return;
+  if(++k1_dup_items[item].lost >= K1_DUP_LOST_MAX)
+    k1_dup_backoff(item);
+}
+
+/// @name k1_dup_take_sent
+/// @brief The function takes the reply started since the previous call, its
+/// @brief echo is expected.
+static void k1_dup_take_sent(void)
+{
+  k1_tx_last_type last;
+  k1_tx_get_last(&last);
+  if(last.seq == k1_dup_sent.seq)
+    return;
+  // the echo of the previous reply is lost
+  if(k1_dup_echo_pending)
+    k1_dup_lost(k1_dup_sent.item);
+  k1_dup_sent = last;
+  k1_dup_echo_pending = 1U;
+  k1_dup_echo_deadline_ms = time_base_deadline_ms(K1_DUP_ECHO_TIMEOUT_MS);
+}
+
+void k1_dup_init(uint32_t seed)
+{
+  // xorshift never leaves 0
+  k1_dup_random = (seed != 0U) ? seed : 0x4B43U;
+  for(uint8_t i = 0; i < K1_NUM_OF_ITEMS; ++i)
+    k1_dup_reset(i);
+  k1_tx_get_last(&k1_dup_sent);
+  k1_dup_echo_pending = 0;
+}
+
+void k1_dup_set_handler(k1_dup_handler_type handler)
+{
+  k1_dup_confirmed_handler = handler;
+}
+
+void k1_dup_reset(uint8_t item)
+{
+  if(item < K1_NUM_OF_ITEMS)
+  {
+    k1_dup_items[item].state = K1_DUP_NORM;
+    k1_dup_items[item].polls_left = 0;
+    k1_dup_items[item].lost = 0;
+  }
+}
+
+uint8_t k1_dup_challenge(void)
+{
+  return (uint8_t)(k1_dup_next_random() >> 24);
+}
+
+void k1_dup_poll(uint8_t item)
+{
+  if((item >= K1_NUM_OF_ITEMS) || (k1_dup_items[item].state != K1_DUP_BACKOFF))
+    return;
+  k1_dup_item_type * it = &k1_dup_items[item];
+  // no other device has answered the POLLs of the back-off
+  if(it->polls_left == 0U)
+  {
+    it->state = K1_DUP_NORM;
+    ++k1_dup_stats.cleared;
+  }
+  else
+  {
+    --it->polls_left;
+  }
+}
+
+void k1_dup_frame(const uint8_t * buf, uint8_t len)
+{
+  // a corrupt frame proves nothing, its echo is lost at the timeout
+  if((k1_frame_check_bytes(buf, len) != K1_FRAME_OK) || (buf[K1_FRAME_CMD_POS] != K1_FRAME_CMD_STATE))
+    return;
+  uint8_t item = k1_addr_get_item(buf[K1_FRAME_SRC_POS]);
+  if(item >= K1_NUM_OF_ITEMS)
+    return;
+  // the echo may end before the K1 task has seen the start of the reply
+  k1_dup_take_sent();
+  if(k1_dup_echo_pending && (k1_dup_sent.item == item))
+  {
+    k1_dup_echo_pending = 0;
+    uint8_t same = (len == k1_dup_sent.len);
+    for(uint8_t i = 0; same && (i < len); ++i)
+      same = (buf[i] == k1_dup_sent.frame[i]);
+    if(same)
+    {
+      ++k1_dup_stats.echoes;
+      k1_dup_items[item].lost = 0;
+      return;
+    }
+  }
+  // another device replies with our address
+  ++k1_dup_stats.collisions;
+  k1_dup_backoff(item);
+}
+
+void k1_dup_handler(void)
+{
+  k1_dup_take_sent();
+  if(k1_dup_echo_pending && time_base_is_expired(k1_dup_echo_deadline_ms))
+  {
+    k1_dup_echo_pending = 0;
+    k1_dup_lost(k1_dup_sent.item);
+  }
+  // an alarm is reported at once
+  for(uint8_t i = 0; i < K1_NUM_OF_ITEMS; ++i)
+  {
+    if((k1_dup_items[i].state == K1_DUP_BACKOFF) && k1_dup_is_alarm(i))
+    {
+      k1_dup_items[i].state = K1_DUP_NORM;
+      ++k1_dup_stats.alarm_holds;
+    }
+  }
+}
+
+uint8_t k1_dup_may_reply(uint8_t item)
+{
+  return (item < K1_NUM_OF_ITEMS) && (k1_dup_items[item].state != K1_DUP_BACKOFF);
+}
+
+k1_dup_state_type k1_dup_get_state(uint8_t item)
+{
+  return (item < K1_NUM_OF_ITEMS) ? k1_dup_items[item].state : K1_DUP_NORM;
+}
+
+void k1_dup_get_stats(k1_dup_stats_type * stats)
+{
+  *stats = k1_dup_stats;
+}
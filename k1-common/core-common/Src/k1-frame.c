@@ -0,0 +1,141 @@
+/// *****************************************************************************
+/// @file           : k1-frame.c
+/// @brief          : k1 bus frame parser
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "crc32.h"
+#include "device-config.h"
+#include "k1-addr.h"
+#include "k1-frame.h"
+#include "settings.h"
+
+/// @name k1_frame_crc
+/// @brief The function calculates CRC-32/MPEG-2 of the frame bytes in the
+/// @brief CRC unit or in software, the frame may wrap over the end of the
+/// @brief ring buffer.
+/// @param raw received frame
+/// @param len number of bytes from the frame begin
+/// @param sw 1 - software only, for interrupts
+/// @return CRC value
+static uint32_t k1_frame_crc(const k1_rx_frame_type * raw, uint16_t len, uint8_t sw)
+{
+  crc32_ctx_type ctx;
+  uint16_t first = (uint16_t)(K1_RX_BUF_SIZE - raw->start);
+  if(sw)
+    crc32_begin_sw(&ctx);
+  else
+    crc32_begin(&ctx);
+  if(len <= first)
+  {
+    crc32_update_bytes(&ctx, &raw->buf[raw->start], len);
+  }
+  else
+  {
+    crc32_update_bytes(&ctx, &raw->buf[raw->start], first);
+    crc32_update_bytes(&ctx, raw->buf, (uint32_t)(len - first));
+  }
+  return crc32_end(&ctx);
+}
+
+uint8_t k1_frame_addr_match(uint8_t dst)
+{
+  if((dst == SETS_K1_ADDR_BROADCAST) || (dst == SETS_K1_ADDR_PULT))
+  {
+    return 1U;
+  }
+  return k1_addr_is_own(dst);
+}
+
+/// @name k1_frame_check
+/// @brief The function checks length and CRC of the received frame.
+/// @param raw received frame
+/// @param sw 1 - CRC in software only, for interrupts
+/// @return K1_FRAME_OK or error code
+static K1_FRAME_ERR_CODES k1_frame_check(const k1_rx_frame_type * raw, uint8_t sw)
+{
+  if(raw->len < (K1_FRAME_HDR_LEN + K1_FRAME_CRC_LEN))
+  {
+    return K1_FRAME_LEN_ERR;
+  }
+  uint8_t len = k1_rx_frame_byte(raw, K1_FRAME_LEN_POS);
+  if(raw->len != (uint16_t)(K1_FRAME_HDR_LEN + len + K1_FRAME_CRC_LEN))
+  {
+    return K1_FRAME_LEN_ERR;
+  }
+
+  // CRC is stored MSB first after the payload
+  uint16_t crc_pos = (uint16_t)(K1_FRAME_HDR_LEN + len);
+  uint32_t crc = 0;
+  for(uint16_t i = 0; i < K1_FRAME_CRC_LEN; ++i)
+  {
+    crc = (crc << 8) | k1_rx_frame_byte(raw, (uint16_t)(crc_pos + i));
+  }
+  if(crc != k1_frame_crc(raw, crc_pos, sw))
+  {
+    return K1_FRAME_CRC_ERR;
+  }
+  return K1_FRAME_OK;
+}
+
+K1_FRAME_ERR_CODES k1_frame_check_isr(const k1_rx_frame_type * raw)
+{
+  return k1_frame_check(raw, 1U);
+}
+
+K1_FRAME_ERR_CODES k1_frame_parse(const k1_rx_frame_type * raw, k1_frame_type * frame)
+{
+  K1_FRAME_ERR_CODES ret_val = k1_frame_check(raw, 0U);
+  if(ret_val != K1_FRAME_OK)
+  {
+    return ret_val;
+  }
+
+  frame->raw = *raw;
+  frame->dst = k1_rx_frame_byte(raw, K1_FRAME_DST_POS);
+  frame->src = k1_rx_frame_byte(raw, K1_FRAME_SRC_POS);
+  frame->cmd = k1_rx_frame_byte(raw, K1_FRAME_CMD_POS);
+  frame->len = k1_rx_frame_byte(raw, K1_FRAME_LEN_POS);
+  return K1_FRAME_OK;
+}
+
+K1_FRAME_ERR_CODES k1_frame_check_bytes(const uint8_t * buf, uint16_t len)
+{
+  if((len < (K1_FRAME_HDR_LEN + K1_FRAME_CRC_LEN)) ||
+     (len != (uint16_t)(K1_FRAME_HDR_LEN + buf[K1_FRAME_LEN_POS] + K1_FRAME_CRC_LEN)))
+  {
+    return K1_FRAME_LEN_ERR;
+  }
+  uint16_t crc_pos = (uint16_t)(len - K1_FRAME_CRC_LEN);
+  uint32_t crc = 0;
+  for(uint16_t i = 0; i < K1_FRAME_CRC_LEN; ++i)
+  {
+    crc = (crc << 8) | buf[crc_pos + i];
+  }
+  return (crc == crc32_calc_bytes(buf, crc_pos)) ? K1_FRAME_OK : K1_FRAME_CRC_ERR;
+}
+
+uint16_t k1_frame_build(uint8_t * buf, uint8_t dst, uint8_t src, uint8_t cmd,
+                        const uint8_t * payload, uint8_t len)
+{
+  buf[K1_FRAME_DST_POS] = dst;
+  buf[K1_FRAME_SRC_POS] = src;
+  buf[K1_FRAME_CMD_POS] = cmd;
+  buf[K1_FRAME_LEN_POS] = len;
+  for(uint8_t i = 0; i < len; ++i)
+  {
+    buf[K1_FRAME_HDR_LEN + i] = payload[i];
+  }
+  uint16_t crc_pos = (uint16_t)(K1_FRAME_HDR_LEN + len);
+  uint32_t crc = crc32_calc_bytes(buf, crc_pos);
+  // CRC is stored MSB first
+  for(uint16_t i = 0; i < K1_FRAME_CRC_LEN; ++i)
+  {
+    buf[crc_pos + i] = (uint8_t)(crc >> (8U * (K1_FRAME_CRC_LEN - 1U - i)));
+  }
+  return (uint16_t)(crc_pos + K1_FRAME_CRC_LEN);
+}
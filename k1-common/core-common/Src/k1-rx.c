@@ -0,0 +1,230 @@
+/// *****************************************************************************
+/// @file           : k1-rx.c
+/// @brief          : k1 bus receive engine (USART2 + DMA1 circular buffer)
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "k1-rx.h"
+
+// descriptor of complete frame
+typedef struct
+{
+  uint32_t start; // position of the first byte in the received stream
+  uint16_t len;   // number of bytes in the frame
+  uint64_t end_us; // time of the frame end
+} k1_rx_desc_type;
+
+// UART of the K1 bus
+static UART_HandleTypeDef * k1_rx_uart = 0;
+
+// DMA ring buffer
+static uint8_t k1_rx_buf[K1_RX_BUF_SIZE];
+
+// complete frames, written by ISR (head) and read by application (tail)
+static k1_rx_desc_type k1_rx_queue[K1_RX_QUEUE_SIZE];
+static volatile uint32_t k1_rx_queue_head = 0;
+static volatile uint32_t k1_rx_queue_tail = 0;
+
+// number of bytes written by DMA up to the last Rx event (wraps at 2^32)
+static volatile uint32_t k1_rx_total = 0;
+
+// stream position of the first byte of the frame being received
+static uint32_t k1_rx_frame_start = 0;
+
+// filter state of the frame being received
+enum
+{
+  K1_RX_FRAME_NEW,      // first byte is not checked yet
+  K1_RX_FRAME_ACCEPTED, // frame is queued at IDLE
+  K1_RX_FRAME_SKIPPED   // frame is for other device
+};
+static uint8_t k1_rx_frame_state = K1_RX_FRAME_NEW;
+
+// filter of frames by the first byte
+static volatile k1_rx_filter_type k1_rx_filter = 0;
+
+// handler of the frame end
+static volatile k1_rx_end_handler_type k1_rx_end_handler = 0;
+
+// counters
+static k1_rx_stats_type k1_rx_stats = {0};
+
+/// @name k1_rx_start
+/// @brief The function (re)starts circular reception till IDLE.
+/// @return K1_RX_OK or K1_RX_ERR
+static K1_RX_ERR_CODES k1_rx_start(void)
+{
+  K1_RX_ERR_CODES ret_val = K1_RX_ERR;
+  if(HAL_UARTEx_ReceiveToIdle_DMA(k1_rx_uart, k1_rx_buf, K1_RX_BUF_SIZE) == HAL_OK)
+  {
+    ret_val = K1_RX_OK;
+  }
+  return ret_val;
+}
+
+/// @name k1_rx_live_total
+/// @brief The function returns the stream position of DMA right now,
+/// @brief including bytes received after the last Rx event.
+/// @return number of bytes written by DMA (wraps at 2^32)
+static uint32_t k1_rx_live_total(void)
+{
+  uint32_t total = k1_rx_total;
+  uint32_t pos = K1_RX_BUF_SIZE - __HAL_DMA_GET_COUNTER(k1_rx_uart->hdmarx);
+  return total + ((pos - total) & K1_RX_BUF_MASK);
+}
+
+K1_RX_ERR_CODES k1_rx_init(UART_HandleTypeDef * uart)
+{
+  K1_RX_ERR_CODES ret_val = K1_RX_ERR;
+  if((uart != 0) && (uart->hdmarx != 0))
+  {
+    k1_rx_uart = uart;
+    k1_rx_queue_head = 0;
+    k1_rx_queue_tail = 0;
+    k1_rx_total = 0;
+    k1_rx_frame_start = 0;
+    k1_rx_frame_state = K1_RX_FRAME_NEW;
+    ret_val = k1_rx_start();
+  }
+  return ret_val;
+}
+
+void k1_rx_set_filter(k1_rx_filter_type filter)
+{
+  k1_rx_filter = filter;
+}
+
+void k1_rx_set_end_handler(k1_rx_end_handler_type handler)
+{
+  k1_rx_end_handler = handler;
+}
+
+uint8_t k1_rx_frame_peek(k1_rx_frame_type * frame)
+{
+  while(k1_rx_queue_tail != k1_rx_queue_head)
+  {
+    const k1_rx_desc_type * desc = &k1_rx_queue[k1_rx_queue_tail & (K1_RX_QUEUE_SIZE - 1U)];
+    // the frame is still in the buffer
+    if((k1_rx_live_total() - desc->start) <= K1_RX_BUF_SIZE)
+    {
+      frame->buf = k1_rx_buf;
+      frame->start = (uint16_t)(desc->start & K1_RX_BUF_MASK);
+      frame->len = desc->len;
+      frame->end_us = desc->end_us;
+      return 1U;
+    }
+    // DMA has already overwritten the frame
+    ++k1_rx_stats.buf_overrun;
+    ++k1_rx_queue_tail;
+  }
+  return 0U;
+}
+
+K1_RX_ERR_CODES k1_rx_frame_release(void)
+{
+  K1_RX_ERR_CODES ret_val = K1_RX_ERR;
+  if(k1_rx_queue_tail != k1_rx_queue_head)
+  {
+    const k1_rx_desc_type * desc = &k1_rx_queue[k1_rx_queue_tail & (K1_RX_QUEUE_SIZE - 1U)];
+    if((k1_rx_live_total() - desc->start) <= K1_RX_BUF_SIZE)
+    {
+      ret_val = K1_RX_OK;
+    }
+    else
+    {
+      ++k1_rx_stats.buf_overrun;
+    }
+    ++k1_rx_queue_tail;
+  }
+  return ret_val;
+}
+
+void k1_rx_get_stats(k1_rx_stats_type * stats)
+{
+  *stats = k1_rx_stats;
+}
+
+void k1_rx_event_isr(uint16_t pos, uint8_t idle)
+{
+  // update the stream position, pos == K1_RX_BUF_SIZE means wrap to 0
+  uint32_t total = k1_rx_total;
+  total += ((uint32_t)pos - total) & K1_RX_BUF_MASK;
+  k1_rx_total = total;
+
+  // the first event with bytes of the frame checks the destination, it is
+  // IDLE at the frame end unless the frame crosses a half of the buffer:
+  // frames for other devices cost neither queueing nor CRC
+  if((k1_rx_frame_state == K1_RX_FRAME_NEW) && (total != k1_rx_frame_start))
+  {
+    k1_rx_filter_type filter = k1_rx_filter;
+    if((filter == 0) || filter(k1_rx_buf[k1_rx_frame_start & K1_RX_BUF_MASK]))
+      k1_rx_frame_state = K1_RX_FRAME_ACCEPTED;
+    else
+      k1_rx_frame_state = K1_RX_FRAME_SKIPPED;
+  }
+
+  if(idle)
+  {
+    uint64_t end_us = time_base_us();
+    uint32_t len = total - k1_rx_frame_start;
+    if(k1_rx_frame_state == K1_RX_FRAME_SKIPPED)
+    {
+      ++k1_rx_stats.filtered;
+    }
+    else if(len > K1_RX_FRAME_MAX_LEN)
+    {
+      ++k1_rx_stats.too_long;
+    }
+    else if(len > 0U)
+    {
+      // queue is full
+      if((k1_rx_queue_head - k1_rx_queue_tail) >= K1_RX_QUEUE_SIZE)
+      {
+        ++k1_rx_stats.queue_overflow;
+      }
+      else
+      {
+        k1_rx_desc_type * desc = &k1_rx_queue[k1_rx_queue_head & (K1_RX_QUEUE_SIZE - 1U)];
+        desc->start = k1_rx_frame_start;
+        desc->len = (uint16_t)len;
+        desc->end_us = end_us;
+        ++k1_rx_stats.frames;
+        ++k1_rx_queue_head;
+      }
+      // time critical reaction on the frame end
+      k1_rx_end_handler_type handler = k1_rx_end_handler;
+      if(handler != 0)
+      {
+        k1_rx_frame_type frame = {k1_rx_buf, (uint16_t)(k1_rx_frame_start & K1_RX_BUF_MASK), (uint16_t)len, end_us};
+        handler(&frame);
+      }
+    }
+    // the next frame starts here
+    k1_rx_frame_start = total;
+    k1_rx_frame_state = K1_RX_FRAME_NEW;
+  }
+}
+
+void k1_rx_error_isr(uint32_t error_code)
+{
+  if(error_code & HAL_UART_ERROR_ORE)
+    ++k1_rx_stats.overrun;
+  if(error_code & HAL_UART_ERROR_NE)
+    ++k1_rx_stats.noise;
+  if(error_code & HAL_UART_ERROR_FE)
+    ++k1_rx_stats.framing;
+  if(error_code & HAL_UART_ERROR_PE)
+    ++k1_rx_stats.parity;
+
+  // DMA restarts from the buffer begin: continue the stream from the next
+  // lap, so queued frames stay valid till DMA reaches them again.
+  // The frame being received is corrupted and dropped.
+  k1_rx_total = (k1_rx_total + K1_RX_BUF_MASK) & ~K1_RX_BUF_MASK;
+  k1_rx_frame_start = k1_rx_total;
+  k1_rx_frame_state = K1_RX_FRAME_NEW;
+  k1_rx_start();
+}
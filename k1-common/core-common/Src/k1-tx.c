@@ -0,0 +1,263 @@
+/// *****************************************************************************
+/// @file           : k1-tx.c
+/// @brief          : k1 bus reply transmitter (TIM1 CH1 + DMA1 channel 5)
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "k1-addr.h"
+#include "k1-frame.h"
+#include "k1-phy.h"
+#include "k1-tx.h"
+#include "settings.h"
+#include "time-base.h"
+
+// reply of the item
+typedef struct
+{
+  uint8_t frame[K1_TX_FRAME_MAX_LEN];
+  uint8_t len;
+  volatile uint8_t armed;
+  volatile uint32_t started;  // replies started, the interrupt only
+  volatile uint64_t start_us; // start of the last reply
+} k1_tx_reply_type;
+
+// timer of the K1 line
+static TIM_HandleTypeDef * k1_tx_tim = 0;
+
+// pause between the request and the reply
+static uint16_t k1_tx_turnaround_us = K1_PHY_TURNAROUND_US;
+
+// armed replies
+static k1_tx_reply_type k1_tx_replies[K1_NUM_OF_ITEMS];
+
+// the last started reply, seq is changed after the frame
+static k1_tx_last_type k1_tx_last = {0};
+static volatile uint32_t k1_tx_last_seq = 0;
+
+// pulse widths of the reply being transmitted, loaded to CCR1 by DMA
+static uint16_t k1_tx_symbols[K1_TX_SYMBOLS_MAX];
+
+static volatile uint8_t k1_tx_busy = 0;
+
+// counters
+static k1_tx_stats_type k1_tx_stats = {0};
+
+/// @name k1_tx_stop
+/// @brief The function stops the timer, the line is already idle.
+static void k1_tx_stop(void)
+{
+  TIM_TypeDef * tim = k1_tx_tim->Instance;
+  tim->DIER &= ~TIM_DIER_UDE;
+  tim->CR1 &= ~TIM_CR1_CEN;
+  k1_tx_busy = 0;
+}
+
+/// DMA has loaded the last symbol: 2 idle symbols are in CCR1 and preload
+static void k1_tx_dma_cplt(DMA_HandleTypeDef * hdma)
+{
+  k1_tx_stop();
+  ++k1_tx_stats.sent;
+}
+
+static void k1_tx_dma_error(DMA_HandleTypeDef * hdma)
+{
+  k1_tx_tim->Instance->CCR1 = 0;
+  k1_tx_stop();
+  ++k1_tx_stats.dma_err;
+}
+
+/// @name k1_tx_encode
+/// @brief The function converts the reply into pulse widths of the symbols.
+/// @param reply reply of the item
+/// @return number of symbols
+static uint16_t k1_tx_encode(const k1_tx_reply_type * reply)
+{
+  uint16_t n = 0;
+  k1_tx_symbols[n++] = K1_PHY_SYNC_PULSE_US;
+  for(uint8_t i = 0; i < reply->len; ++i)
+  {
+    for(uint8_t mask = 0x80U; mask != 0U; mask >>= 1)
+    {
+      k1_tx_symbols[n++] = (reply->frame[i] & mask) ? K1_PHY_BIT1_PULSE_US : K1_PHY_BIT0_PULSE_US;
+    }
+  }
+  k1_tx_symbols[n++] = 0;
+  k1_tx_symbols[n++] = 0;
+  return n;
+}
+
+/// @name k1_tx_start
+/// @brief The function starts the reply: turnaround pause, then symbols.
+/// @param reply reply of the item
+/// @param item item's number of the reply
+static void k1_tx_start(const k1_tx_reply_type * reply, uint8_t item)
+{
+  TIM_TypeDef * tim = k1_tx_tim->Instance;
+  uint16_t n = k1_tx_encode(reply);
+
+  tim->CR1 &= ~TIM_CR1_CEN;
+  tim->DIER &= ~TIM_DIER_UDE;
+  // the first period is the pause, the line is idle
+  tim->ARR = (uint32_t)k1_tx_turnaround_us - 1U;
+  tim->CCR1 = 0;
+  // load shadow registers, no DMA request from UG
+  tim->CR1 |= TIM_CR1_URS;
+  tim->EGR = TIM_EGR_UG;
+  // preload: active from the end of the pause
+  tim->ARR = K1_PHY_BIT_PERIOD_US - 1U;
+  tim->CCR1 = k1_tx_symbols[0];
+  if(HAL_DMA_Start_IT(k1_tx_tim->hdma[TIM_DMA_ID_UPDATE], (uint32_t)&k1_tx_symbols[1],
+                      (uint32_t)&tim->CCR1, (uint32_t)(n - 1U)) != HAL_OK)
+  {
+    tim->CCR1 = 0;
+    ++k1_tx_stats.dma_err;
+    return;
+  }
+  k1_tx_busy = 1;
+  // keep the frame for the echo check of the line
+  for(uint8_t i = 0; i < reply->len; ++i)
+  {
+    k1_tx_last.frame[i] = reply->frame[i];
+  }
+  k1_tx_last.len = reply->len;
+  k1_tx_last.item = item;
+  ++k1_tx_last_seq;
+  tim->DIER |= TIM_DIER_UDE;
+  tim->CCER |= TIM_CCER_CC1E;
+  tim->BDTR |= TIM_BDTR_MOE;
+  tim->CR1 |= TIM_CR1_CEN;
+}
+
+K1_TX_ERR_CODES k1_tx_init(TIM_HandleTypeDef * tim)
+{
+  K1_TX_ERR_CODES ret_val = K1_TX_ERR;
+  if((tim != 0) && (tim->hdma[TIM_DMA_ID_UPDATE] != 0))
+  {
+    k1_tx_tim = tim;
+    for(uint8_t item = 0; item < K1_NUM_OF_ITEMS; ++item)
+    {
+      k1_tx_replies[item].armed = 0;
+    }
+    tim->hdma[TIM_DMA_ID_UPDATE]->XferCpltCallback = k1_tx_dma_cplt;
+    tim->hdma[TIM_DMA_ID_UPDATE]->XferHalfCpltCallback = 0;
+    tim->hdma[TIM_DMA_ID_UPDATE]->XferErrorCallback = k1_tx_dma_error;
+    k1_tx_busy = 0;
+    ret_val = K1_TX_OK;
+  }
+  return ret_val;
+}
+
+void k1_tx_set_turnaround(uint16_t turnaround_us)
+{
+  if(turnaround_us > 0U)
+  {
+    k1_tx_turnaround_us = turnaround_us;
+  }
+}
+
+K1_TX_ERR_CODES k1_tx_arm(uint8_t item, uint8_t cmd, const uint8_t * payload, uint8_t len)
+{
+  K1_TX_ERR_CODES ret_val = K1_TX_ERR;
+  uint8_t src = k1_addr_get(item);
+  if((item < K1_NUM_OF_ITEMS) && (src != 0U) &&
+     ((K1_FRAME_HDR_LEN + len + K1_FRAME_CRC_LEN) <= K1_TX_FRAME_MAX_LEN))
+  {
+    k1_tx_reply_type * reply = &k1_tx_replies[item];
+    // the interrupt does not take the reply while it is changed
+    reply->armed = 0;
+    reply->len = (uint8_t)k1_frame_build(reply->frame, SETS_K1_ADDR_PULT, src, cmd, payload, len);
+    reply->armed = 1;
+    ret_val = K1_TX_OK;
+  }
+  return ret_val;
+}
+
+void k1_tx_disarm(uint8_t item)
+{
+  if(item < K1_NUM_OF_ITEMS)
+  {
+    k1_tx_replies[item].armed = 0;
+  }
+}
+
+uint8_t k1_tx_is_armed(uint8_t item)
+{
+  return (item < K1_NUM_OF_ITEMS) ? k1_tx_replies[item].armed : 0U;
+}
+
+uint32_t k1_tx_get_started(uint8_t item, uint64_t * start_us)
+{
+  if(item >= K1_NUM_OF_ITEMS)
+    return 0U;
+  // read again if a reply has started during the read
+  uint32_t started;
+  do
+  {
+    started = k1_tx_replies[item].started;
+    if(start_us != 0)
+      *start_us = k1_tx_replies[item].start_us;
+  } while(started != k1_tx_replies[item].started);
+  return started;
+}
+
+uint8_t k1_tx_is_busy(void)
+{
+  return k1_tx_busy;
+}
+
+void k1_tx_get_last(k1_tx_last_type * last)
+{
+  // copy again if a reply has started during the copy
+  uint32_t seq;
+  do
+  {
+    seq = k1_tx_last_seq;
+    *last = k1_tx_last;
+  } while(seq != k1_tx_last_seq);
+  last->seq = seq;
+}
+
+void k1_tx_get_stats(k1_tx_stats_type * stats)
+{
+  *stats = k1_tx_stats;
+}
+
+void k1_tx_request_end_isr(const k1_rx_frame_type * frame)
+{
+  if((k1_tx_tim == 0) || (frame->len < K1_FRAME_HDR_LEN) ||
+     (k1_rx_frame_byte(frame, K1_FRAME_CMD_POS) != K1_FRAME_CMD_POLL))
+  {
+    return;
+  }
+  uint8_t dst = k1_rx_frame_byte(frame, K1_FRAME_DST_POS);
+  uint8_t item = k1_addr_get_item(dst);
+  if((dst == SETS_K1_ADDR_BROADCAST) || (item >= K1_NUM_OF_ITEMS))
+  {
+    return;
+  }
+  // a broken request must not start a reply over the real addressee
+  if(k1_frame_check_isr(frame) != K1_FRAME_OK)
+  {
+    ++k1_tx_stats.rejected;
+    return;
+  }
+  if(k1_tx_busy)
+  {
+    ++k1_tx_stats.busy;
+  }
+  else if(k1_tx_replies[item].armed)
+  {
+    k1_tx_replies[item].armed = 0;
+    k1_tx_replies[item].start_us = time_base_us();
+    ++k1_tx_replies[item].started;
+    k1_tx_start(&k1_tx_replies[item], item);
+  }
+  else
+  {
+    ++k1_tx_stats.not_armed;
+  }
+}
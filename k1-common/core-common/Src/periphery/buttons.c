@@ -11,121 +11,200 @@
 
 #include "buttons.h"
 #include "device-config.h"
+#include "time-base.h"
 
 const buttons_hw_type BUTTONS_HW[BUTTONS_AMOUNT] =
 {
-  {BTN_1_GPIO_Port, BTN_1_Pin, BUTTONS_MODE_SHORT_PUSH_EN | BUTTONS_MODE_LONG_PUSH_EN}, // corresponds to BUTTON_FUNC_ADDR
+  {BTN_1_GPIO_Port, BTN_1_Pin, BUTTONS_MODE_EDGES_EN},                                 // corresponds to BUTTON_FUNC_ADDR, gestures
   {BTN_2_GPIO_Port, BTN_2_Pin, BUTTONS_MODE_SHORT_PUSH_EN | BUTTONS_MODE_LONG_PUSH_EN}, // corresponds to BUTTON_FUNC_DUMMY1
   {BTN_3_GPIO_Port, BTN_3_Pin, BUTTONS_MODE_SHORT_PUSH_EN | BUTTONS_MODE_LONG_PUSH_EN}, // corresponds to BUTTON_FUNC_DUMMY2
   {BTN_4_GPIO_Port, BTN_4_Pin, BUTTONS_MODE_SHORT_PUSH_EN | BUTTONS_MODE_LONG_PUSH_EN}, // corresponds to BUTTON_FUNC_DUMMY3
-  {BTN_5_GPIO_Port, BTN_5_Pin, BUTTONS_MODE_SHORT_PUSH_EN | BUTTONS_MODE_LONG_PUSH_EN}, // corresponds to BUTTON_FUNC_DUMMY4
 };
 
-// type to store Buttons work values
-static buttons_vals_type buttons_vals[BUTTONS_AMOUNT] = {0};
+// physical pins of the buttons, several buttons may share one pin
+static buttons_pin_type buttons_pins[BUTTONS_AMOUNT];
+static uint8_t buttons_pins_num = 0;
+
+// time till the next update, 0 - idle
+static uint32_t buttons_next_ms = 0;
+static volatile buttons_edge_handler_type buttons_edge_handler = 0;
+
+// queue of the events
+static event_queue_event_type buttons_events_buf[BUTTONS_EVENTS_SIZE];
+static event_queue_type buttons_events;
+
+/// @name buttons_post
+/// @brief The function queues the event for the buttons of the pin.
+/// @param pin physical pin
+/// @param type BUTTONS_EV_...
+/// @param push_ms duration of the push
+/// @param time_us time of the event
+static void buttons_post(const buttons_pin_type * pin, uint16_t type, uint32_t push_ms, uint64_t time_us)
+{
+  for(uint32_t btn = 0; btn < BUTTONS_AMOUNT; ++btn)
+  {
+    if(!(pin->buttons & (0x1UL << btn)))
+      continue;
+    uint8_t mode = BUTTONS_HW[btn].MODE_FLAGS_SET;
+    uint8_t post = 0;
+    if((type == BUTTONS_EV_PUSH) || (type == BUTTONS_EV_RELEASE))
+      post = (mode & BUTTONS_MODE_EDGES_EN) ? 1U : 0U;
+    else if(type == BUTTONS_EV_LONG_PUSH)
+      post = (mode & BUTTONS_MODE_LONG_PUSH_EN) ? 1U : 0U;
+    // for buttons with possibility of long pushing
+    else if((mode & BUTTONS_MODE_SHORT_PUSH_EN) && (mode & BUTTONS_MODE_LONG_PUSH_EN))
+      post = ((push_ms > BUTTONS_SHORT_PUSH_VAL_MS) && (push_ms < BUTTONS_LONG_PUSH_VAL_MS)) ? 1U : 0U;
+    // for buttons without possibility of long pushing
+    else if(mode & BUTTONS_MODE_SHORT_PUSH_EN)
+      post = (push_ms > BUTTONS_SHORT_PUSH_VAL_MS) ? 1U : 0U;
+    if(post)
+      event_queue_post(&buttons_events, type, (uint16_t)btn, time_us);
+  }
+}
 
 BUTTONS_FAIL_TYPE buttons_init()
 {
-  for(uint32_t i = 0; i < BUTTONS_AMOUNT; ++i)
+  // one entry per physical pin
+  buttons_pins_num = 0;
+  for(uint32_t btn = 0; btn < BUTTONS_AMOUNT; ++btn)
   {
-    buttons_vals[i].push_counter = 0;
-    buttons_vals[i].release_counter = 0;
-    buttons_vals[i].short_push_flag = 0;
-    buttons_vals[i].long_push_flag = 0;
-    buttons_vals[i].release_flag = 0;
+    uint8_t i = 0;
+    while((i < buttons_pins_num) &&
+          ((buttons_pins[i].BASE != BUTTONS_HW[btn].BASE) || (buttons_pins[i].PIN != BUTTONS_HW[btn].PIN)))
+      ++i;
+    if(i == buttons_pins_num)
+    {
+      buttons_pins[i].BASE = BUTTONS_HW[btn].BASE;
+      buttons_pins[i].PIN = BUTTONS_HW[btn].PIN;
+      buttons_pins[i].buttons = 0;
+      buttons_pins[i].edge_us = 0;
+      buttons_pins[i].edges = 0;
+      buttons_pins[i].edges_seen = 0;
+      buttons_pins[i].pushed = (HAL_GPIO_ReadPin(BUTTONS_HW[btn].BASE, BUTTONS_HW[btn].PIN) == GPIO_PIN_RESET) ? 1U : 0U;
+      // a push before the start gives no events
+      buttons_pins[i].long_sent = 1U;
+      buttons_pins[i].push_us = 0;
+      ++buttons_pins_num;
+    }
+    buttons_pins[i].buttons |= 0x1UL << btn;
   }
+  buttons_next_ms = 0;
+  if(event_queue_init(&buttons_events, buttons_events_buf, BUTTONS_EVENTS_SIZE) != EVENT_QUEUE_OK)
+    return BUTTONS_FAIL;
   return BUTTONS_OK;
 }
 
 BUTTONS_FAIL_TYPE buttons_handler()
 {
-  static uint32_t prev_ms_counter = 0;
-  uint32_t period_ms = HAL_GetTick() - prev_ms_counter;
-  BUTTONS_FAIL_TYPE ret_val = BUTTONS_FAIL;
-  if(period_ms < 500)
+  uint64_t next_us = UINT64_MAX;
+  for(uint8_t i = 0; i < buttons_pins_num; ++i)
   {
-    for(uint32_t btn = 0; btn < BUTTONS_AMOUNT; ++btn)
+    buttons_pin_type * pin = &buttons_pins[i];
+    // the last edge, read again if EXTI interrupt has come between
+    uint8_t edges;
+    uint64_t edge_us;
+    do
+    {
+      edges = pin->edges;
+      edge_us = pin->edge_us;
+    } while(edges != pin->edges);
+    // no edges and no long push to wait for: no work
+    if((edges == pin->edges_seen) && !(pin->pushed && !pin->long_sent))
+      continue;
+    uint64_t now_us = time_base_us();
+
+    // anti debouncing filter: wait for the pin to be stable
+    uint64_t stable_us = edge_us + BUTTONS_RELEASE_VAL_MS * 1000ULL;
+    if(now_us < stable_us)
+    {
+      if(stable_us < next_us)
+        next_us = stable_us;
+      continue;
+    }
+
+    uint8_t pushed = (HAL_GPIO_ReadPin(pin->BASE, pin->PIN) == GPIO_PIN_RESET) ? 1U : 0U;
+    // the event "button was pushed"
+    if(pushed && !pin->pushed)
+    {
+      pin->pushed = 1U;
+      pin->long_sent = 0;
+      pin->push_us = edge_us;
+      buttons_post(pin, BUTTONS_EV_PUSH, 0, edge_us);
+    }
+    // the event "button was released": short pushing events
+    else if(!pushed && pin->pushed)
+    {
+      pin->pushed = 0;
+      uint32_t push_ms = (uint32_t)((edge_us - pin->push_us) / 1000U);
+      if(!pin->long_sent)
+        buttons_post(pin, BUTTONS_EV_SHORT_PUSH, push_ms, pin->push_us);
+      buttons_post(pin, BUTTONS_EV_RELEASE, push_ms, edge_us);
+    }
+    // no work till the next edge but the long push
+    pin->edges_seen = edges;
+
+    // long pushing events
+    if(pin->pushed && !pin->long_sent)
     {
-      // button is pushed
-      if(HAL_GPIO_ReadPin(BUTTONS_HW[btn].BASE, BUTTONS_HW[btn].PIN) == GPIO_PIN_RESET)
+      uint64_t long_us = pin->push_us + BUTTONS_LONG_PUSH_VAL_MS * 1000ULL;
+      if(now_us >= long_us)
       {
-        if(buttons_vals[btn].push_counter < BUTTONS_LONG_PUSH_VAL_MS)
-        {
-          buttons_vals[btn].push_counter += period_ms;
-        }
-        // long pushing events
-        else if((BUTTONS_HW[btn].MODE_FLAGS_SET & BUTTONS_MODE_LONG_PUSH_EN) && (buttons_vals[btn].release_flag == 1))
-        {
-          buttons_vals[btn].long_push_flag = 1;
-          buttons_vals[btn].release_flag = 0;
-        }
-
-        // reset release_counter
-        if(buttons_vals[btn].push_counter > BUTTONS_RELEASE_VAL_MS)
-          buttons_vals[btn].release_counter = 0;
+        pin->long_sent = 1U;
+        buttons_post(pin, BUTTONS_EV_LONG_PUSH, BUTTONS_LONG_PUSH_VAL_MS, pin->push_us);
       }
-      // button is released
-      else
+      else if(long_us < next_us)
       {
-        // anti debouncing filter
-        if(buttons_vals[btn].release_counter < BUTTONS_RELEASE_VAL_MS)
-        {
-          buttons_vals[btn].release_counter += period_ms;
-        }
-        // the event "button was released"
-        else
-        {
-          // short pushing events
-          if(BUTTONS_HW[btn].MODE_FLAGS_SET & BUTTONS_MODE_SHORT_PUSH_EN)
-          {
-            // for buttons with possibility of long pushing
-            if(BUTTONS_HW[btn].MODE_FLAGS_SET & BUTTONS_MODE_LONG_PUSH_EN)
-            {
-              if((buttons_vals[btn].push_counter > BUTTONS_SHORT_PUSH_VAL_MS) && (buttons_vals[btn].push_counter < BUTTONS_LONG_PUSH_VAL_MS))
-                buttons_vals[btn].short_push_flag = 1;
-            }
-            // for buttons without possibility of long pushing
-            else
-            {
-              if(buttons_vals[btn].push_counter > BUTTONS_SHORT_PUSH_VAL_MS)
-                buttons_vals[btn].short_push_flag = 1;
-            }
-          } // short pushing events
-
-          buttons_vals[btn].release_flag = 1;
-          buttons_vals[btn].push_counter = 0;
-        } // the event "button was released"
-      } // button is released
+        next_us = long_us;
+      }
     }
-    ret_val = BUTTONS_OK;
   }
-  prev_ms_counter = HAL_GetTick();
-  return ret_val;
+
+  buttons_next_ms = 0;
+  if(next_us != UINT64_MAX)
+  {
+    uint64_t now_us = time_base_us();
+    buttons_next_ms = (next_us > now_us) ? (uint32_t)((next_us - now_us + 999U) / 1000U) : 1U;
+  }
+  return BUTTONS_OK;
 }
 
-uint32_t buttons_get_short_push_flags()
+uint32_t buttons_get_next_ms(void)
 {
-  uint32_t ret_flags = 0;
+  return buttons_next_ms;
+}
 
-  for(uint32_t btn = 0; btn < BUTTONS_AMOUNT; ++btn)
-  {
-    if(buttons_vals[btn].short_push_flag == 1)
-      ret_flags |= 0x1UL << btn;
-    buttons_vals[btn].short_push_flag = 0;
-  }
-  return ret_flags;
+void buttons_set_edge_handler(buttons_edge_handler_type handler)
+{
+  buttons_edge_handler = handler;
 }
 
-uint32_t buttons_get_long_push_flags()
+void buttons_exti_isr(uint16_t pin)
 {
-  uint32_t ret_flags = 0;
-  for(uint32_t btn = 0; btn < BUTTONS_AMOUNT; ++btn)
+  uint8_t edge = 0;
+  uint64_t now_us = time_base_us();
+  for(uint8_t i = 0; i < buttons_pins_num; ++i)
   {
-    if(buttons_vals[btn].long_push_flag == 1)
-      ret_flags |= 0x1UL << btn;
-    buttons_vals[btn].long_push_flag = 0;
+    if(buttons_pins[i].PIN & pin)
+    {
+      // the time is written before the counter, the task checks the counter
+      buttons_pins[i].edge_us = now_us;
+      ++buttons_pins[i].edges;
+      edge = 1U;
+    }
   }
-  return ret_flags;
+  buttons_edge_handler_type handler = buttons_edge_handler;
+  if(edge && (handler != 0))
+    handler();
+}
+
+uint8_t buttons_get_event(event_queue_event_type * event)
+{
+  return event_queue_get(&buttons_events, event);
+}
+
+void buttons_get_event_stats(event_queue_stats_type * stats)
+{
+  event_queue_get_stats(&buttons_events, stats);
 }
 
 uint8_t buttons_get_raw_state(uint32_t button_num)
@@ -23,7 +23,7 @@
 #include "device-config.h"
 
 /* USER CODE BEGIN 0 */
-
+#include "buttons.h"
 /* USER CODE END 0 */
 
 /*----------------------------------------------------------------------------*/
@@ -62,12 +62,22 @@ void MX_GPIO_Init(void)
 
   /*Configure GPIO pin : addr_button_Pin */
   GPIO_InitStruct.Pin = addr_button_Pin;
-  GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+  GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
   GPIO_InitStruct.Pull = GPIO_PULLUP;
   HAL_GPIO_Init(addr_button_GPIO_Port, &GPIO_InitStruct);
 
+  /* EXTI interrupt init*/
+  HAL_NVIC_SetPriority(EXTI15_10_IRQn, 3, 0);
+  HAL_NVIC_EnableIRQ(EXTI15_10_IRQn);
+
 }
 
 /* USER CODE BEGIN 2 */
 
+/// edge of EXTI line: buttons
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  buttons_exti_isr(GPIO_Pin);
+}
+
 /* USER CODE END 2 */
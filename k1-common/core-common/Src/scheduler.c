@@ -0,0 +1,168 @@
+/// *****************************************************************************
+/// @file           : scheduler.c
+/// @brief          : cooperative scheduler with static task table
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "scheduler.h"
+
+// run time state of the task
+typedef struct
+{
+  volatile uint64_t due_ms;   // time of the next run
+  volatile uint8_t active;    // 1 - the task waits for due_ms
+} sched_state_type;
+
+// table of the application
+static const sched_task_type * sched_tasks = 0;
+static uint8_t sched_tasks_num = 0;
+
+static sched_state_type sched_state[SCHED_TASKS_MAX];
+static sched_stats_type sched_stats[SCHED_TASKS_MAX];
+
+SCHED_ERR_CODES sched_init(const sched_task_type * tasks, uint8_t num)
+{
+  SCHED_ERR_CODES ret_val = SCHED_ERR;
+  if((tasks != 0) && (num > 0U) && (num <= SCHED_TASKS_MAX))
+  {
+    uint64_t now = time_base_ms();
+    sched_tasks_num = 0;
+    sched_tasks = tasks;
+    for(uint8_t i = 0; i < num; ++i)
+    {
+      sched_state[i].due_ms = now;
+      sched_state[i].active = (tasks[i].period_ms != 0U) ? 1U : 0U;
+      sched_stats[i] = (sched_stats_type){0};
+    }
+    sched_tasks_num = num;
+    ret_val = SCHED_OK;
+  }
+  return ret_val;
+}
+
+SCHED_ERR_CODES sched_start(uint8_t task, uint32_t delay_ms)
+{
+  SCHED_ERR_CODES ret_val = SCHED_ERR;
+  if(task < sched_tasks_num)
+  {
+    uint64_t due = time_base_deadline_ms(delay_ms);
+    // the 64-bit time and the flag change together for the dispatcher and
+    // for a start from another interrupt
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    sched_state[task].due_ms = due;
+    sched_state[task].active = 1;
+    __set_PRIMASK(primask);
+    ret_val = SCHED_OK;
+  }
+  return ret_val;
+}
+
+SCHED_ERR_CODES sched_stop(uint8_t task)
+{
+  SCHED_ERR_CODES ret_val = SCHED_ERR;
+  if(task < sched_tasks_num)
+  {
+    sched_state[task].active = 0;
+    ret_val = SCHED_OK;
+  }
+  return ret_val;
+}
+
+/// @name sched_find_due
+/// @brief The function finds the due task with the highest priority, the
+/// @brief first in the table wins. The interrupts must be masked.
+/// @param now time in ms
+/// @return index of the task, SCHED_TASKS_MAX - no task is due
+static uint8_t sched_find_due(uint64_t now)
+{
+  uint8_t best = SCHED_TASKS_MAX;
+  for(uint8_t i = 0; i < sched_tasks_num; ++i)
+  {
+    if(sched_state[i].active && (now >= sched_state[i].due_ms) &&
+       ((best == SCHED_TASKS_MAX) || (sched_tasks[i].priority < sched_tasks[best].priority)))
+    {
+      best = i;
+    }
+  }
+  return best;
+}
+
+uint8_t sched_dispatch(void)
+{
+  // a start from an interrupt between the choice and the update of the task
+  // would be lost, the time, the choice and the update are taken with the
+  // interrupts masked
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint64_t now = time_base_ms();
+  uint8_t best = sched_find_due(now);
+  if(best == SCHED_TASKS_MAX)
+  {
+    __set_PRIMASK(primask);
+    return 0U;
+  }
+
+  const sched_task_type * task = &sched_tasks[best];
+  sched_state_type * state = &sched_state[best];
+  sched_stats_type * stats = &sched_stats[best];
+  uint64_t due = state->due_ms;
+  uint32_t late = (uint32_t)(now - due);
+
+  if(late > stats->max_late_ms)
+    stats->max_late_ms = late;
+  if((task->deadline_ms != 0U) && (late > task->deadline_ms))
+    ++stats->misses;
+
+  if(task->period_ms == 0U)
+  {
+    state->active = 0;
+  }
+  else if(late >= task->period_ms)
+  {
+    // whole periods are lost: do not run them in a burst
+    state->due_ms = now + task->period_ms;
+  }
+  else
+  {
+    // no drift of the period
+    state->due_ms = due + task->period_ms;
+  }
+  __set_PRIMASK(primask);
+
+  ++stats->runs;
+  task->func();
+  return 1U;
+}
+
+void sched_run(void)
+{
+  while(1)
+  {
+    if(!sched_dispatch())
+    {
+      // a start from an interrupt after the check must not wait for the next
+      // interrupt: the check is masked, the pending interrupt wakes __WFI and
+      // runs after the mask is removed
+      __disable_irq();
+      if(sched_find_due(time_base_ms()) == SCHED_TASKS_MAX)
+        __WFI();
+      __enable_irq();
+    }
+  }
+}
+
+SCHED_ERR_CODES sched_get_stats(uint8_t task, sched_stats_type * stats)
+{
+  SCHED_ERR_CODES ret_val = SCHED_ERR;
+  if(task < sched_tasks_num)
+  {
+    *stats = sched_stats[task];
+    ret_val = SCHED_OK;
+  }
+  return ret_val;
+}
@@ -0,0 +1,338 @@
+/// *****************************************************************************
+/// @file           : sec-loop.c
+/// @brief          : classification of security loops by their resistance
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "sec-loop.h"
+#include "adc-filter.h"
+#include "time-base.h"
+
+// state of the input
+typedef struct
+{
+  uint8_t zone;           // zone of the state, SEC_LOOP_ZONES_MAX - none
+  uint8_t pending;        // zone waiting for the integration time
+  uint64_t pending_us;    // time the pending zone has come
+  uint32_t outputs;       // last taken value of adc-filter
+  uint64_t edge_us;       // the voltage has come into the zone of the state
+  volatile sec_loop_state_type state;
+} sec_loop_input_type;
+
+static sec_loop_config_type sec_loop_config[SEC_LOOP_INPUTS];
+static volatile uint8_t sec_loop_ready = 0;
+static sec_loop_input_type sec_loop_input[SEC_LOOP_INPUTS];
+static volatile sec_loop_handler_type sec_loop_handler = 0;
+
+// fast path
+static ADC_HandleTypeDef * sec_loop_adc = 0;
+static TIM_HandleTypeDef * sec_loop_trigger = 0;
+static uint8_t sec_loop_armed = SEC_LOOP_INPUTS;  // watched input, SEC_LOOP_INPUTS - none
+static uint16_t sec_loop_vin_q15 = 0;             // supply of the window
+static uint8_t sec_loop_hits = 0;                 // successive samples in alarm zone
+static uint8_t sec_loop_stale = 0;                // 1 - the last sample read was inside the window
+static uint64_t sec_loop_hit_us = 0;              // time of the last one
+static uint64_t sec_loop_scan_us = 0;             // start of the scan of the first one
+static sec_loop_fast_stats_type sec_loop_fast_stats = {0};
+
+/// @name sec_loop_below
+/// @brief The function compares the loop voltage with the bound scaled by
+/// @brief the supply voltage.
+/// @param line_q15 loop voltage
+/// @param bound_q15 bound, Q15 ratio to v_in_mon
+/// @param vin_q15 supply voltage
+/// @return 1 - the loop voltage is below the bound
+static uint8_t sec_loop_below(uint16_t line_q15, uint32_t bound_q15, uint16_t vin_q15)
+{
+  return (((uint64_t)line_q15 << 15) < ((uint64_t)bound_q15 * vin_q15)) ? 1U : 0U;
+}
+
+/// @name sec_loop_set_zone
+/// @brief The function sets the zone of the input, the state change raises
+/// @brief the event.
+/// @param input input number
+/// @param zone index of the zone
+/// @param edge_us time the voltage has come into the zone
+static void sec_loop_set_zone(uint8_t input, uint8_t zone, uint64_t edge_us)
+{
+  sec_loop_input_type * in = &sec_loop_input[input];
+  in->zone = zone;
+  in->pending = zone;
+  sec_loop_state_type state = sec_loop_config[input].zones[zone].state;
+  if(state == in->state)
+    return;
+  in->edge_us = edge_us;
+  in->state = state;
+  sec_loop_handler_type handler = sec_loop_handler;
+  if(handler != 0)
+    handler(input, state, edge_us);
+}
+
+/// @name sec_loop_fast_arm
+/// @brief The function sets the window of the analog watchdog to the zone
+/// @brief of the first fast input out of alarm.
+/// @param vin_q15 supply voltage, Q15 of ADC full scale
+static void sec_loop_fast_arm(uint16_t vin_q15)
+{
+  if(sec_loop_adc == 0)
+    return;
+  uint8_t input = 0;
+  for(; input < SEC_LOOP_INPUTS; ++input)
+  {
+    const sec_loop_config_type * config = &sec_loop_config[input];
+    uint8_t zone = sec_loop_input[input].zone;
+    if((config->zones != 0) && config->fast && (zone < config->zones_num) &&
+       (config->zones[zone].state != SEC_LOOP_ALARM))
+      break;
+  }
+
+  uint32_t channel = adc_scan_get_adc_channel(ADC_SCAN_SECURITY1);
+  uint32_t it = 0;
+  uint32_t high = 0x0FFFU;
+  uint32_t low = 0;
+  if((input < SEC_LOOP_INPUTS) && (vin_q15 >= SEC_LOOP_VIN_MIN_Q15))
+  {
+    // bounds of the zone with the hysteresis, 12 bit samples
+    const sec_loop_config_type * config = &sec_loop_config[input];
+    uint8_t zone = sec_loop_input[input].zone;
+    // filtered values carry the gain correction, the samples do not
+    uint32_t vin = ((uint32_t)vin_q15 << (ADC_FILTER_GAIN_SHIFT - 3U)) / adc_filter_get_gain();
+    if((zone > 0U) && (config->zones[zone - 1U].upper_q15 > config->hyst_q15))
+      low = ((uint32_t)(config->zones[zone - 1U].upper_q15 - config->hyst_q15) * vin) >> 15;
+    if(zone < (config->zones_num - 1U))
+    {
+      high = (((uint32_t)config->zones[zone].upper_q15 + config->hyst_q15) * vin) >> 15;
+      if(high > 0x0FFFU)
+        high = 0x0FFFU;
+    }
+    channel = adc_scan_get_adc_channel((adc_scan_channel_type)(ADC_SCAN_SECURITY1 + input));
+    it = ADC_CR1_AWDIE;
+  }
+  else
+  {
+    input = SEC_LOOP_INPUTS;
+  }
+  if(input != sec_loop_armed)
+    sec_loop_hits = 0;
+  sec_loop_stale = 0;
+  sec_loop_armed = input;
+  sec_loop_vin_q15 = vin_q15;
+  // the registers are written directly: HAL_ADC_AnalogWDGConfig() takes the
+  // lock of the handle, it fails when this interrupt comes in a HAL call of
+  // the task and the window would not follow sec_loop_armed
+  ADC_TypeDef * adc = sec_loop_adc->Instance;
+  adc->HTR = high;
+  adc->LTR = low;
+  MODIFY_REG(adc->CR1, ADC_CR1_AWDCH | ADC_CR1_AWDSGL | ADC_CR1_AWDEN | ADC_CR1_JAWDEN | ADC_CR1_AWDIE,
+             (channel & ADC_CR1_AWDCH) | ADC_CR1_AWDSGL | ADC_CR1_AWDEN | it);
+}
+
+SEC_LOOP_ERR_CODES sec_loop_init(const sec_loop_config_type * config, uint8_t num)
+{
+  if(num > SEC_LOOP_INPUTS)
+    return SEC_LOOP_ERR;
+  for(uint8_t i = 0; i < num; ++i)
+  {
+    if((config[i].zones != 0) &&
+       ((config[i].zones_num == 0U) || (config[i].zones_num > SEC_LOOP_ZONES_MAX)))
+      return SEC_LOOP_ERR;
+  }
+  sec_loop_ready = 0;
+  for(uint8_t i = 0; i < SEC_LOOP_INPUTS; ++i)
+  {
+    if(i < num)
+      sec_loop_config[i] = config[i];
+    else
+      sec_loop_config[i].zones = 0;
+    sec_loop_input[i].zone = SEC_LOOP_ZONES_MAX;
+    sec_loop_input[i].pending = SEC_LOOP_ZONES_MAX;
+    sec_loop_input[i].pending_us = 0;
+    sec_loop_input[i].outputs = 0;
+    sec_loop_input[i].edge_us = 0;
+    sec_loop_input[i].state = SEC_LOOP_UNDEFINED;
+  }
+  sec_loop_armed = SEC_LOOP_INPUTS;
+  sec_loop_hits = 0;
+  sec_loop_stale = 0;
+  sec_loop_ready = 1U;
+  return SEC_LOOP_OK;
+}
+
+SEC_LOOP_ERR_CODES sec_loop_fast_init(ADC_HandleTypeDef * adc, TIM_HandleTypeDef * trigger)
+{
+  if((adc == 0) || (trigger == 0))
+    return SEC_LOOP_ERR;
+  sec_loop_trigger = trigger;
+  sec_loop_adc = adc;
+  return SEC_LOOP_OK;
+}
+
+void sec_loop_set_handler(sec_loop_handler_type handler)
+{
+  sec_loop_handler = handler;
+}
+
+uint8_t sec_loop_classify(const sec_loop_config_type * config, uint16_t line_q15, uint16_t vin_q15,
+                          uint8_t current)
+{
+  const sec_loop_zone_type * zones = config->zones;
+  uint8_t last = config->zones_num - 1U;
+  uint8_t zone = 0;
+  while((zone < last) && !sec_loop_below(line_q15, zones[zone].upper_q15, vin_q15))
+    ++zone;
+
+  // the current zone is kept till the voltage goes beyond its bounds by the hysteresis
+  if((current <= last) && (zone != current))
+  {
+    if(zone > current)
+    {
+      if(sec_loop_below(line_q15, (uint32_t)zones[current].upper_q15 + config->hyst_q15, vin_q15))
+        zone = current;
+    }
+    else if(zones[current - 1U].upper_q15 > config->hyst_q15)
+    {
+      if(!sec_loop_below(line_q15, zones[current - 1U].upper_q15 - config->hyst_q15, vin_q15))
+        zone = current;
+    }
+    else
+    {
+      zone = current;
+    }
+  }
+  return zone;
+}
+
+void sec_loop_update(uint8_t input, uint16_t line_q15, uint16_t vin_q15, uint64_t now_us)
+{
+  if(!sec_loop_ready || (input >= SEC_LOOP_INPUTS) || (sec_loop_config[input].zones == 0))
+    return;
+  const sec_loop_config_type * config = &sec_loop_config[input];
+  sec_loop_input_type * in = &sec_loop_input[input];
+
+  // no supply, the loop voltage means nothing
+  if(vin_q15 < SEC_LOOP_VIN_MIN_Q15)
+  {
+    in->pending = in->zone;
+    return;
+  }
+
+  uint8_t zone = sec_loop_classify(config, line_q15, vin_q15, in->zone);
+  if(zone == in->zone)
+  {
+    in->pending = zone;
+    return;
+  }
+  if(zone != in->pending)
+  {
+    in->pending = zone;
+    in->pending_us = now_us;
+  }
+  if((now_us - in->pending_us) < ((uint64_t)config->integration_ms * 1000U))
+    return;
+  sec_loop_set_zone(input, zone, in->pending_us);
+}
+
+void sec_loop_isr(void)
+{
+  if(!sec_loop_ready)
+    return;
+  uint16_t vin_q15 = (uint16_t)adc_filter_get_q15(ADC_SCAN_V_IN);
+  uint64_t now_us = time_base_us();
+  uint8_t updated = 0;
+  for(uint8_t i = 0; i < SEC_LOOP_INPUTS; ++i)
+  {
+    adc_scan_channel_type ch = (adc_scan_channel_type)(ADC_SCAN_SECURITY1 + i);
+    uint32_t outputs = adc_filter_get_outputs(ch);
+    if(outputs == sec_loop_input[i].outputs)
+      continue;
+    sec_loop_input[i].outputs = outputs;
+    sec_loop_update(i, (uint16_t)adc_filter_get_q15(ch), vin_q15, now_us);
+    updated = 1U;
+  }
+  if(updated)
+    sec_loop_fast_arm(vin_q15);
+}
+
+void sec_loop_awd_isr(void)
+{
+  uint64_t now_us = time_base_us();
+  uint32_t scan_us = __HAL_TIM_GET_COUNTER(sec_loop_trigger);
+  ++sec_loop_fast_stats.wakeups;
+  uint8_t input = sec_loop_armed;
+  if(!sec_loop_ready || (input >= SEC_LOOP_INPUTS))
+  {
+    __HAL_ADC_DISABLE_IT(sec_loop_adc, ADC_IT_AWD);
+    return;
+  }
+
+  const sec_loop_config_type * config = &sec_loop_config[input];
+  uint32_t sample = adc_scan_get_latest((adc_scan_channel_type)(ADC_SCAN_SECURITY1 + input));
+  uint16_t line_q15 = (uint16_t)(((sample << 3) * adc_filter_get_gain()) >> ADC_FILTER_GAIN_SHIFT);
+  uint8_t zone = sec_loop_classify(config, line_q15, sec_loop_vin_q15, sec_loop_input[input].zone);
+  if((zone == sec_loop_input[input].zone) && !sec_loop_stale)
+  {
+    // DMA has not written the sample out of the window yet, the next scan
+    // tells: the watchdog stays armed
+    ++sec_loop_fast_stats.inconclusive;
+    sec_loop_stale = 1U;
+    return;
+  }
+  sec_loop_stale = 0;
+  if((zone == sec_loop_input[input].zone) || (config->zones[zone].state != SEC_LOOP_ALARM))
+  {
+    // not an alarm, the window waits for the next filtered value
+    __HAL_ADC_DISABLE_IT(sec_loop_adc, ADC_IT_AWD);
+    sec_loop_hits = 0;
+    return;
+  }
+
+  // the watchdog fires on every scan while the samples are out of the window
+  if((sec_loop_hits == 0U) || ((now_us - sec_loop_hit_us) > (2U * ADC_SCAN_PERIOD_US)))
+  {
+    sec_loop_hits = 0;
+    sec_loop_scan_us = now_us - scan_us;
+  }
+  sec_loop_hit_us = now_us;
+  if(++sec_loop_hits < SEC_LOOP_FAST_SAMPLES)
+    return;
+
+  __HAL_ADC_DISABLE_IT(sec_loop_adc, ADC_IT_AWD);
+  sec_loop_hits = 0;
+  sec_loop_armed = SEC_LOOP_INPUTS;
+  sec_loop_set_zone(input, zone, sec_loop_scan_us);
+  uint32_t latency = (uint32_t)(time_base_us() - sec_loop_scan_us);
+  ++sec_loop_fast_stats.alarms;
+  sec_loop_fast_stats.last_us = latency;
+  if(latency > sec_loop_fast_stats.max_us)
+    sec_loop_fast_stats.max_us = latency;
+}
+
+void sec_loop_get_fast_stats(sec_loop_fast_stats_type * stats)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  *stats = sec_loop_fast_stats;
+  __set_PRIMASK(primask);
+}
+
+sec_loop_state_type sec_loop_get_state(uint8_t input)
+{
+  return (input < SEC_LOOP_INPUTS) ? sec_loop_input[input].state : SEC_LOOP_UNDEFINED;
+}
+
+uint64_t sec_loop_get_edge_us(uint8_t input)
+{
+  uint64_t ret_val = 0;
+  if(input < SEC_LOOP_INPUTS)
+  {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ret_val = sec_loop_input[input].edge_us;
+    __set_PRIMASK(primask);
+  }
+  return ret_val;
+}
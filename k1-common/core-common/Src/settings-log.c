@@ -0,0 +1,364 @@
+/// *****************************************************************************
+/// @file           : settings-log.c
+/// @brief          : wear-levelled log of settings records in 2 flash pages
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include <string.h>
+#include "settings-log.h"
+#include "crc32.h"
+#include "flash-async.h"
+#include "device-config.h"
+
+#define SETTINGS_LOG_PAGES          2U
+#define SETTINGS_LOG_PAGE_MAGIC     0x4B31534CU // "K1SL"
+#define SETTINGS_LOG_REC_MAGIC      0x5E7CU
+#define SETTINGS_LOG_CRC_SIZE       4U
+
+// header of the page, programmed when the page is complete
+typedef struct
+{
+  uint32_t magic;
+  uint32_t generation;  // the page with the newest generation is active
+} settings_log_page_hdr_type;
+
+// header of the record
+typedef struct
+{
+  uint16_t magic;
+  uint16_t version;     // version of the payload format
+  uint16_t len;         // payload length in bytes
+  uint16_t len_inv;     // ~len, guards a torn header
+} settings_log_rec_hdr_type;
+
+static const uint32_t SETTINGS_LOG_PAGE_ADDR[SETTINGS_LOG_PAGES] =
+{
+  FLASH_SETS_MAIN_ADDR,
+  FLASH_SETS_COPY_ADDR
+};
+
+// active page, SETTINGS_LOG_PAGES - no valid page
+static uint8_t settings_log_active = SETTINGS_LOG_PAGES;
+static uint32_t settings_log_generation = 0;
+// offset of the free space in the active page
+static uint32_t settings_log_free = SETTINGS_LOG_PAGE_SIZE;
+// the last valid record
+static const settings_log_rec_hdr_type * settings_log_last = 0;
+
+// image of the record being written
+static uint32_t settings_log_buf[(sizeof(settings_log_rec_hdr_type) + SETTINGS_LOG_PAYLOAD_MAX +
+                                  SETTINGS_LOG_CRC_SIZE) / 4U];
+// header of the page for compaction
+static settings_log_page_hdr_type settings_log_page_hdr;
+
+// steps of the background write
+enum
+{
+  SETTINGS_LOG_JOB_IDLE,
+  SETTINGS_LOG_JOB_ERASE,   // erase the other page
+  SETTINGS_LOG_JOB_RECORD,  // program the record
+  SETTINGS_LOG_JOB_HEADER,  // program the header of the new page
+  SETTINGS_LOG_JOB_FINISH   // wait for the last operation
+};
+
+// background write
+typedef struct
+{
+  uint8_t state;
+  uint8_t page;         // page of the record
+  uint8_t compaction;   // 1 - the record starts the other page
+  uint32_t addr;        // flash address of the record
+  uint16_t size;        // size of the record
+  volatile uint8_t pending;   // 1 - the flash operation is queued
+  volatile uint8_t res;       // FLASH_ASYNC_ERR_CODES of the operation
+} settings_log_job_type;
+
+static settings_log_job_type settings_log_job = {0};
+
+static settings_log_stats_type settings_log_stats = {0};
+
+/// @name settings_log_rec_size
+/// @brief The function returns the size of the record in flash.
+/// @param len payload length
+/// @return size in bytes, multiple of 4
+static uint32_t settings_log_rec_size(uint32_t len)
+{
+  return sizeof(settings_log_rec_hdr_type) + ((len + 3U) & ~3U) + SETTINGS_LOG_CRC_SIZE;
+}
+
+/// @name settings_log_page_generation
+/// @brief The function checks the header of the page.
+/// @param page index of the page
+/// @param generation pointer to store the generation of the page
+/// @return 1 - the page is valid
+static uint8_t settings_log_page_generation(uint8_t page, uint32_t * generation)
+{
+  const settings_log_page_hdr_type * hdr = (const settings_log_page_hdr_type *)SETTINGS_LOG_PAGE_ADDR[page];
+  *generation = hdr->generation;
+  return ((hdr->magic == SETTINGS_LOG_PAGE_MAGIC) && (hdr->generation != 0xFFFFFFFFU)) ? 1U : 0U;
+}
+
+/// @name settings_log_scan
+/// @brief The function finds the last valid record and the free space of
+/// @brief the active page.
+static void settings_log_scan(void)
+{
+  uint32_t base = SETTINGS_LOG_PAGE_ADDR[settings_log_active];
+  uint32_t offset = sizeof(settings_log_page_hdr_type);
+  settings_log_last = 0;
+  settings_log_free = SETTINGS_LOG_PAGE_SIZE;
+
+  while((offset + sizeof(settings_log_rec_hdr_type)) <= SETTINGS_LOG_PAGE_SIZE)
+  {
+    const settings_log_rec_hdr_type * rec = (const settings_log_rec_hdr_type *)(base + offset);
+    // erased space: the end of the log
+    if(rec->magic == 0xFFFFU)
+    {
+      settings_log_free = offset;
+      break;
+    }
+    uint32_t size = settings_log_rec_size(rec->len);
+    // garbage: nothing can be appended, the next write compacts the log
+    if((rec->magic != SETTINGS_LOG_REC_MAGIC) || ((uint16_t)(rec->len ^ rec->len_inv) != 0xFFFFU) ||
+       (rec->len > SETTINGS_LOG_PAYLOAD_MAX) || ((offset + size) > SETTINGS_LOG_PAGE_SIZE))
+    {
+      break;
+    }
+    const uint32_t * words = (const uint32_t *)rec;
+    uint32_t num = (size - SETTINGS_LOG_CRC_SIZE) / 4U;
+    if(crc32_calc_words(words, num) == words[num])
+      settings_log_last = rec;
+    else
+      ++settings_log_stats.bad_records;
+    offset += size;
+  }
+}
+
+/// @name settings_log_done
+/// @brief The function takes the result of the flash operation.
+/// @param res FLASH_ASYNC_OK or FLASH_ASYNC_FLASH_ERR
+/// @param ctx not used
+static void settings_log_done(FLASH_ASYNC_ERR_CODES res, void * ctx)
+{
+  (void)ctx;
+  settings_log_job.res = (uint8_t)res;
+  settings_log_job.pending = 0;
+}
+
+/// @name settings_log_is_blank
+/// @brief The function checks that the page is erased.
+/// @param page index of the page
+/// @return 1 - the page is blank, its erase is not needed
+static uint8_t settings_log_is_blank(uint8_t page)
+{
+  const uint32_t * words = (const uint32_t *)SETTINGS_LOG_PAGE_ADDR[page];
+  for(uint32_t i = 0; i < (SETTINGS_LOG_PAGE_SIZE / 4U); ++i)
+  {
+    if(words[i] != 0xFFFFFFFFU)
+      return 0U;
+  }
+  return 1U;
+}
+
+/// @name settings_log_submit
+/// @brief The function queues the flash operation of the job.
+/// @param res result of flash_async_xxx()
+/// @return SETTINGS_LOG_BUSY or SETTINGS_LOG_FLASH_ERR - it is not queued
+static SETTINGS_LOG_ERR_CODES settings_log_submit(FLASH_ASYNC_ERR_CODES res)
+{
+  if(res == FLASH_ASYNC_OK)
+    return SETTINGS_LOG_BUSY;
+  settings_log_job.pending = 0;
+  settings_log_job.res = FLASH_ASYNC_FLASH_ERR;
+  return SETTINGS_LOG_FLASH_ERR;
+}
+
+SETTINGS_LOG_ERR_CODES settings_log_init(void)
+{
+  uint32_t generation[SETTINGS_LOG_PAGES];
+  uint8_t valid[SETTINGS_LOG_PAGES];
+
+  settings_log_active = SETTINGS_LOG_PAGES;
+  for(uint8_t page = 0; page < SETTINGS_LOG_PAGES; ++page)
+  {
+    valid[page] = settings_log_page_generation(page, &generation[page]);
+    // the newest valid page, generations are compared over the wrap
+    if(valid[page] && ((settings_log_active == SETTINGS_LOG_PAGES) ||
+                       ((int32_t)(generation[page] - settings_log_generation) > 0)))
+    {
+      settings_log_active = page;
+      settings_log_generation = generation[page];
+    }
+  }
+
+  if(settings_log_active == SETTINGS_LOG_PAGES)
+  {
+    settings_log_last = 0;
+    settings_log_free = SETTINGS_LOG_PAGE_SIZE;
+    return SETTINGS_LOG_EMPTY;
+  }
+  settings_log_scan();
+  return (settings_log_last != 0) ? SETTINGS_LOG_OK : SETTINGS_LOG_EMPTY;
+}
+
+const uint8_t * settings_log_read(uint16_t * version, uint16_t * len)
+{
+  if(settings_log_last == 0)
+    return 0;
+  *version = settings_log_last->version;
+  *len = settings_log_last->len;
+  return (const uint8_t *)(settings_log_last + 1);
+}
+
+SETTINGS_LOG_ERR_CODES settings_log_begin(const void * payload, uint16_t len, uint16_t version)
+{
+  settings_log_job_type * job = &settings_log_job;
+  if((payload == 0) || (len == 0U) || (len > SETTINGS_LOG_PAYLOAD_MAX))
+    return SETTINGS_LOG_ERR;
+  if(job->state != SETTINGS_LOG_JOB_IDLE)
+    return SETTINGS_LOG_BUSY;
+
+  // image of the record
+  uint32_t size = settings_log_rec_size(len);
+  uint32_t num = size / 4U;
+  settings_log_rec_hdr_type * hdr = (settings_log_rec_hdr_type *)settings_log_buf;
+  memset(settings_log_buf, 0, size);
+  hdr->magic = SETTINGS_LOG_REC_MAGIC;
+  hdr->version = version;
+  hdr->len = len;
+  hdr->len_inv = (uint16_t)~len;
+  memcpy(hdr + 1, payload, len);
+  settings_log_buf[num - 1U] = crc32_calc_words(settings_log_buf, num - 1U);
+
+  job->size = (uint16_t)size;
+  job->pending = 0;
+  job->res = FLASH_ASYNC_OK;
+  // append into the active page
+  if((settings_log_active < SETTINGS_LOG_PAGES) && ((settings_log_free + size) <= SETTINGS_LOG_PAGE_SIZE))
+  {
+    job->page = settings_log_active;
+    job->compaction = 0;
+    job->addr = SETTINGS_LOG_PAGE_ADDR[job->page] + settings_log_free;
+    job->state = SETTINGS_LOG_JOB_RECORD;
+  }
+  // compaction: the record is the first one in the other page
+  else
+  {
+    job->page = (settings_log_active < SETTINGS_LOG_PAGES) ? (uint8_t)(settings_log_active ^ 1U) : 0U;
+    job->compaction = 1;
+    job->addr = SETTINGS_LOG_PAGE_ADDR[job->page] + sizeof(settings_log_page_hdr_type);
+    settings_log_page_hdr.magic = SETTINGS_LOG_PAGE_MAGIC;
+    settings_log_page_hdr.generation = settings_log_generation + 1U;
+    job->state = SETTINGS_LOG_JOB_ERASE;
+  }
+  return SETTINGS_LOG_OK;
+}
+
+SETTINGS_LOG_ERR_CODES settings_log_step(void)
+{
+  settings_log_job_type * job = &settings_log_job;
+  SETTINGS_LOG_ERR_CODES ret_val = SETTINGS_LOG_BUSY;
+  if(job->state == SETTINGS_LOG_JOB_IDLE)
+    return SETTINGS_LOG_OK;
+
+  // the operation is running, it is completed by the FLASH interrupt
+  // or here when the interrupts are disabled
+  flash_async_poll();
+  if(job->pending)
+    return SETTINGS_LOG_BUSY;
+
+  if(job->res == FLASH_ASYNC_OK)
+  {
+    job->pending = 1;
+    switch(job->state)
+    {
+      case SETTINGS_LOG_JOB_ERASE:
+        job->state = SETTINGS_LOG_JOB_RECORD;
+        if(settings_log_is_blank(job->page))
+          job->pending = 0;
+        else
+        {
+          ++settings_log_stats.erases;
+          ret_val = settings_log_submit(flash_async_erase(SETTINGS_LOG_PAGE_ADDR[job->page], settings_log_done, 0));
+        }
+        break;
+
+      case SETTINGS_LOG_JOB_RECORD:
+        // the page becomes active by its header
+        job->state = job->compaction ? SETTINGS_LOG_JOB_HEADER : SETTINGS_LOG_JOB_FINISH;
+        ret_val = settings_log_submit(flash_async_program(job->addr, (const uint16_t *)settings_log_buf,
+                                                          job->size / 2U, settings_log_done, 0));
+        break;
+
+      case SETTINGS_LOG_JOB_HEADER:
+        job->state = SETTINGS_LOG_JOB_FINISH;
+        ret_val = settings_log_submit(flash_async_program(SETTINGS_LOG_PAGE_ADDR[job->page],
+                                                          (const uint16_t *)&settings_log_page_hdr,
+                                                          sizeof(settings_log_page_hdr) / 2U,
+                                                          settings_log_done, 0));
+        break;
+
+      default:
+        job->pending = 0;
+        job->state = SETTINGS_LOG_JOB_IDLE;
+        ret_val = SETTINGS_LOG_OK;
+        break;
+    }
+  }
+  else
+  {
+    ret_val = SETTINGS_LOG_FLASH_ERR;
+  }
+
+  if(ret_val == SETTINGS_LOG_FLASH_ERR)
+  {
+    ++settings_log_stats.flash_err;
+    // the space of the active page is spoilt, the next write compacts the
+    // log; a failed compaction leaves the old page active
+    if(!job->compaction)
+      settings_log_free = SETTINGS_LOG_PAGE_SIZE;
+    job->state = SETTINGS_LOG_JOB_IDLE;
+    return SETTINGS_LOG_FLASH_ERR;
+  }
+  if(ret_val == SETTINGS_LOG_BUSY)
+    return SETTINGS_LOG_BUSY;
+
+  // the record is complete
+  if(job->compaction)
+  {
+    settings_log_active = job->page;
+    settings_log_generation = settings_log_page_hdr.generation;
+    settings_log_free = sizeof(settings_log_page_hdr_type);
+  }
+  settings_log_last = (const settings_log_rec_hdr_type *)job->addr;
+  settings_log_free += job->size;
+  ++settings_log_stats.appends;
+  return SETTINGS_LOG_OK;
+}
+
+SETTINGS_LOG_ERR_CODES settings_log_append(const void * payload, uint16_t len, uint16_t version)
+{
+  SETTINGS_LOG_ERR_CODES ret_val = settings_log_begin(payload, len, version);
+  if(ret_val == SETTINGS_LOG_OK)
+  {
+    do
+    {
+      ret_val = settings_log_step();
+    } while(ret_val == SETTINGS_LOG_BUSY);
+  }
+  return ret_val;
+}
+
+uint8_t settings_log_is_busy(void)
+{
+  return (settings_log_job.state != SETTINGS_LOG_JOB_IDLE) ? 1U : 0U;
+}
+
+void settings_log_get_stats(settings_log_stats_type * stats)
+{
+  *stats = settings_log_stats;
+}
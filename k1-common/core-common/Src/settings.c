@@ -15,180 +15,332 @@
 /// - Встроенный UID
 /// - Контроль дублирующего адреса
 
+#include <string.h>
 #include "settings.h"
 #include "main.h"
+#include "crc32.h"
 #include "device-config.h"
+#include "flash-async.h"
+#include "settings-log.h"
 
-// interface for CRC calculating
-static CRC_HandleTypeDef * settings_crc_interface = 0;
+// field of settings
+typedef struct
+{
+  uint8_t size;     // number of bytes
+  uint8_t def;      // default of every byte, the field is not written
+} settings_field_type;
+
+// schema of settings, the fields are indexed by their tags
+static const settings_field_type SETTINGS_SCHEMA[SETS_TAGS_AMOUNT] =
+{
+  //                        size              default
+  [SETS_TAG_DEVICE_TYPE] = {1U,               SETS_DEV_TYPE_UNDEFINED},
+  [SETS_TAG_K1_ADDRESS] =  {K1_NUM_OF_ITEMS,  SETS_K1_ADDR_BROADCAST},
+};
 
-// RAM copy of settings
-static settings_type settings = {0};
+// builder of the index for a version of the record format
+typedef uint8_t (*settings_indexer_type)(const uint8_t * record, uint16_t len);
 
-// stored settings CRC (read after power on)
-static uint32_t settings_stored_crc = 0;
+static uint8_t settings_index_v2(const uint8_t * record, uint16_t len);
+static uint8_t settings_index_tlv(const uint8_t * record, uint16_t len);
 
-enum
+// supported formats, older ones are migrated by the next commit
+static const struct
+{
+  uint16_t version;
+  settings_indexer_type indexer;
+} SETTINGS_FORMATS[] =
 {
-  SETS_MAIN_COPY,
-  SETS_SPARE_COPY
+  {2U,            settings_index_v2},
+  {SETS_VERSION,  settings_index_tlv},
 };
 
-/// @name settings_read
-/// @author Aleksandr Shumilov
-/// created 03.06.2025
-/// @brief The function reads settings from main or copy area in flash.
-/// @brief Checks CRC.
-/// @param copy_num SETS_MAIN_COPY or SETS_SPARE_COPY
-/// @return SETS_OK or error code
-static settings_err_code_type settings_read(uint32_t copy_num)
+// fields of the record in FLASH, 0 - the field is absent, default is used
+static const uint8_t * settings_index[SETS_TAGS_AMOUNT];
+
+// changed byte of settings, not written to FLASH yet
+typedef struct
 {
-  settings_err_code_type ret_val = SETS_OK;
-  uint32_t * copy_addr = (copy_num == SETS_MAIN_COPY) ? (uint32_t *)FLASH_SETS_MAIN_ADDR : (uint32_t *)FLASH_SETS_COPY_ADDR;
-  // reading settings from flash is successful
-  for(uint8_t word = 0; word < sizeof(settings_type)/4; ++word)
-  {
-    settings.by_words[word] = copy_addr[word];
-  }
-  // check the CRC
-  if(settings.crc32 != HAL_CRC_Calculate(settings_crc_interface, settings.by_words, sizeof(settings.by_words)))
-  {
-    ret_val = SETS_CRC_FAIL;
-  }
-  else if(settings.version != SETS_VERSION)
+  uint8_t tag;
+  uint8_t index;    // index of the byte in the field
+  uint8_t value;
+  uint8_t writing;  // 1 - the byte is in the record being written
+} settings_change_type;
+
+// RAM overlay of the changes over the record, the latest entry of a byte
+// is the actual one
+static settings_change_type settings_changes[SETS_CHANGES_MAX];
+static uint8_t settings_changes_num = 0;
+
+// fields changed since the last write, SETS_DIRTY_xxx
+static uint32_t settings_dirty = 0;
+// fields of the record being written
+static uint32_t settings_writing = 0;
+// settings_commit() is called
+static uint8_t settings_commit_req = 0;
+// result of the last write
+static settings_err_code_type settings_write_res = SETS_OK;
+
+/// @name settings_index_v2
+/// @brief The function indexes the packed structure of version 2:
+/// @brief device_type, k1_address[K1_NUM_OF_ITEMS].
+/// @param record payload of the record
+/// @param len length of the payload
+/// @return 1 - the record is indexed
+static uint8_t settings_index_v2(const uint8_t * record, uint16_t len)
+{
+  if(len != (1U + K1_NUM_OF_ITEMS))
+    return 0U;
+  settings_index[SETS_TAG_DEVICE_TYPE] = &record[0];
+  settings_index[SETS_TAG_K1_ADDRESS] = &record[1];
+  return 1U;
+}
+
+/// @name settings_index_tlv
+/// @brief The function indexes the fields of TLV record. Unknown tags
+/// @brief (fields of newer firmware) and fields of wrong size are skipped.
+/// @param record payload of the record
+/// @param len length of the payload
+/// @return 1 - the record is indexed
+static uint8_t settings_index_tlv(const uint8_t * record, uint16_t len)
+{
+  uint16_t pos = 0;
+  while((pos + 2U) <= len)
   {
-    ret_val = SETS_VERSION_FAIL;
+    uint8_t tag = record[pos];
+    uint8_t size = record[pos + 1U];
+    if((pos + 2U + size) > len)
+      return 0U;
+    if((tag < SETS_TAGS_AMOUNT) && (size == SETTINGS_SCHEMA[tag].size))
+      settings_index[tag] = &record[pos + 2U];
+    pos += 2U + size;
   }
-  settings_stored_crc = settings.crc32;
-  return ret_val;
+  return 1U;
 }
 
-/// @name settings_verify
-/// @author Aleksandr Shumilov
-/// created 03.06.2025
-/// @brief The function reads the copy  of  settings  from  FLASH  and
-/// @brief compares it to current settings.
-/// @param copy_num SETS_MAIN_COPY or SETS_SPARE_COPY
-/// @return SETS_OK or error code
-static settings_err_code_type settings_verify(uint32_t copy_num)
+/// @name settings_index_update
+/// @brief The function indexes the fields of the last record of the log.
+/// @return SETS_OK, SETS_CRC_FAIL - no valid record, SETS_VERSION_FAIL
+static settings_err_code_type settings_index_update(void)
 {
-  settings_err_code_type ret_val = SETS_OK;
-  const uint32_t * copy_addr = (copy_num == SETS_MAIN_COPY) ? (uint32_t *)FLASH_SETS_MAIN_ADDR : (uint32_t *)FLASH_SETS_COPY_ADDR;
-  // compare to current settings
-  for(uint32_t i = 0; i < (sizeof(settings.by_words) / 4); ++i)
+  uint16_t version = 0;
+  uint16_t len = 0;
+  // the CRC of the record is checked by the scan of the log
+  const uint8_t * record = settings_log_read(&version, &len);
+  memset(settings_index, 0, sizeof(settings_index));
+  if(record == 0)
+    return SETS_CRC_FAIL;
+  for(uint8_t i = 0; i < (sizeof(SETTINGS_FORMATS) / sizeof(SETTINGS_FORMATS[0])); ++i)
   {
-    if(settings.by_words[i] != copy_addr[i])
+    if(SETTINGS_FORMATS[i].version == version)
     {
-      ret_val = SETS_ERR;
+      if(SETTINGS_FORMATS[i].indexer(record, len))
+        return SETS_OK;
+      break;
     }
   }
-  if(settings.crc32 != copy_addr[sizeof(settings.by_words) / 4])
-  {
-    ret_val = SETS_CRC_FAIL;
-  }
-  return ret_val;
+  memset(settings_index, 0, sizeof(settings_index));
+  return SETS_VERSION_FAIL;
 }
 
-/// @name settings_write
-/// @author Aleksandr Shumilov
-/// created 03.06.2025
-/// @brief The function calculates CRC and writes settings  to  FRAM.
-/// @brief copy_num - number of record SETS_MAIN_COPY,SETS_SPARE_COPY
-/// @param copy_num SETS_MAIN_COPY or SETS_SPARE_COPY
-/// @return SETS_OK or error code
-static settings_err_code_type settings_write (uint32_t copy_num)
-{
-  settings_err_code_type ret_val = SETS_ERR;
-  uint32_t copy_addr =
-      (copy_num == SETS_MAIN_COPY) ?
-          FLASH_SETS_MAIN_ADDR : FLASH_SETS_COPY_ADDR;
-  // settings version
-  settings.version = SETS_VERSION;
-  // CRC calculating
-  settings.crc32 = HAL_CRC_Calculate (settings_crc_interface, settings.by_words,
-                                      sizeof(settings.by_words));
-  // unlock flash
-  if (HAL_FLASH_Unlock () == HAL_OK)
+/// @name settings_encode
+/// @brief The function makes the TLV image of the actual settings. Fields
+/// @brief equal to defaults are omitted, the device type is always written.
+/// @param image buffer of SETTINGS_LOG_PAYLOAD_MAX bytes
+/// @return length of the image, 0 - the image does not fit
+static uint16_t settings_encode(uint8_t * image)
+{
+  uint16_t len = 0;
+  for(uint8_t tag = 0; tag < SETS_TAGS_AMOUNT; ++tag)
   {
-    // erase
-    FLASH_EraseInitTypeDef erase_str =
-      {
-      FLASH_TYPEERASE_PAGES,
-      FLASH_BANK_1, copy_addr, 1 };
-    uint32_t err_code = 0;
-    if (HAL_OK == HAL_FLASHEx_Erase (&erase_str, &err_code))
+    const settings_field_type * field = &SETTINGS_SCHEMA[tag];
+    uint8_t used = (tag == SETS_TAG_DEVICE_TYPE) ? 1U : 0U;
+    for(uint8_t i = 0; i < field->size; ++i)
     {
-      for (uint32_t i = 0; i < (sizeof(settings_type) / 4); ++i)
-      {
-        // programm
-        HAL_FLASH_Unlock ();
-        HAL_FLASH_Program (FLASH_TYPEPROGRAM_WORD, ((uint32_t*)copy_addr)[i],
-                           settings.by_words[i]);
-        HAL_FLASH_Lock ();
-      }
-      // verifying
-      ret_val = settings_verify (copy_num);
+      if(settings_get_u8((settings_tag_type)tag, i) != field->def)
+        used = 1U;
     }
+    if(!used)
+      continue;
+    if((len + 2U + field->size) > SETTINGS_LOG_PAYLOAD_MAX)
+      return 0U;
+    image[len++] = tag;
+    image[len++] = field->size;
+    for(uint8_t i = 0; i < field->size; ++i)
+      image[len++] = settings_get_u8((settings_tag_type)tag, i);
   }
-  return ret_val;
+  return len;
 }
 
-settings_err_code_type settings_init(CRC_HandleTypeDef * crc_interface)
+/// @name settings_write_done
+/// @brief The function drops the written changes from the overlay.
+static void settings_write_done(void)
+{
+  uint8_t num = 0;
+  for(uint8_t i = 0; i < settings_changes_num; ++i)
+  {
+    if(!settings_changes[i].writing)
+      settings_changes[num++] = settings_changes[i];
+  }
+  settings_changes_num = num;
+}
+
+settings_err_code_type settings_init(void)
 {
   settings_err_code_type ret_val = SETS_OK;
-  if(crc_interface == 0)
+  memset(settings_index, 0, sizeof(settings_index));
+  settings_changes_num = 0;
+  settings_dirty = 0;
+  settings_writing = 0;
+  settings_commit_req = 0;
+  // the shared CRC service must be set up by crc32_init()
+  if(!crc32_is_ready())
     ret_val = SETS_NO_INTERFACE_FAIL;
+  // no valid record in the log
+  else if(settings_log_init() != SETTINGS_LOG_OK)
+    ret_val = SETS_CRC_FAIL;
   else
-  {
-    // initialize the CRC interface pointer
-    settings_crc_interface = crc_interface;
-    // reading the main copy of settings from FRAM is successful
-    ret_val = settings_read(SETS_MAIN_COPY);
+    ret_val = settings_index_update();
+  return ret_val;
+}
 
-    // read the spare copy of settings
-    if(ret_val != SETS_OK)
-    {
-      // reading the spare copy of settings from FRAM is successful
-      ret_val = settings_read(SETS_SPARE_COPY);
+uint8_t settings_get_u8(settings_tag_type tag, uint8_t index)
+{
+  if((tag >= SETS_TAGS_AMOUNT) || (index >= SETTINGS_SCHEMA[tag].size))
+    return 0U;
+  for(uint8_t i = settings_changes_num; i > 0U; --i)
+  {
+    const settings_change_type * change = &settings_changes[i - 1U];
+    if((change->tag == tag) && (change->index == index))
+      return change->value;
+  }
+  if(settings_index[tag] != 0)
+    return settings_index[tag][index];
+  return SETTINGS_SCHEMA[tag].def;
+}
 
-      // if spare copy is valid we should rewrite the main copy
-      if(ret_val == SETS_OK)
-      {
-        ret_val = settings_write(SETS_MAIN_COPY);
-      }
-    }
-    // rewrite spare copy
-    else
+settings_err_code_type settings_set_u8(settings_tag_type tag, uint8_t index, uint8_t val)
+{
+  if((tag >= SETS_TAGS_AMOUNT) || (index >= SETTINGS_SCHEMA[tag].size))
+    return SETS_ERR;
+  if(settings_get_u8(tag, index) == val)
+    return SETS_OK;
+  // the pending change of the byte is updated, the byte of the record
+  // being written gets a new entry
+  for(uint8_t i = settings_changes_num; i > 0U; --i)
+  {
+    settings_change_type * change = &settings_changes[i - 1U];
+    if((change->tag == tag) && (change->index == index) && !change->writing)
     {
-      ret_val = settings_write(SETS_SPARE_COPY);
+      change->value = val;
+      settings_dirty |= SETS_DIRTY(tag);
+      return SETS_OK;
     }
   }
-  return ret_val;
+  if(settings_changes_num >= SETS_CHANGES_MAX)
+    return SETS_OVERLAY_FAIL;
+  settings_changes[settings_changes_num++] = (settings_change_type){tag, index, val, 0U};
+  settings_dirty |= SETS_DIRTY(tag);
+  return SETS_OK;
 }
 
-uint8_t settings_get_device_type(){return settings.device_type;}
+uint8_t settings_get_device_type(){return settings_get_u8(SETS_TAG_DEVICE_TYPE, 0);}
 uint8_t settings_get_k1_address(uint8_t index)
 {
-  if(index < K1_NUM_OF_ITEMS)
-    return settings.k1_address[index];
-  else
-    return settings.k1_address[0];
+  if(index >= K1_NUM_OF_ITEMS)
+    index = 0;
+  return settings_get_u8(SETS_TAG_K1_ADDRESS, index);
 }
 
 settings_err_code_type settings_set_device_type(uint8_t val)
 {
-  settings.device_type = val;
-  return settings_write(SETS_MAIN_COPY) | settings_write(SETS_SPARE_COPY);
+  return settings_set_u8(SETS_TAG_DEVICE_TYPE, 0, val);
 }
 settings_err_code_type settings_set_k1_address(uint8_t val, uint8_t index)
 {
-  if(index < K1_NUM_OF_ITEMS)
+  return settings_set_u8(SETS_TAG_K1_ADDRESS, index, val);
+}
+
+void settings_commit(void)
+{
+  settings_commit_req = 1;
+}
+
+void settings_handler(void)
+{
+  if(settings_log_is_busy())
+  {
+    SETTINGS_LOG_ERR_CODES res = settings_log_step();
+    if(res == SETTINGS_LOG_BUSY)
+      return;
+    if(res == SETTINGS_LOG_OK)
+    {
+      settings_write_res = SETS_OK;
+      settings_index_update();
+      settings_write_done();
+    }
+    // the record is dropped, its changes are written again
+    else
+    {
+      settings_write_res = SETS_FLASH_FAIL;
+      for(uint8_t i = 0; i < settings_changes_num; ++i)
+        settings_changes[i].writing = 0;
+      settings_dirty |= settings_writing;
+      settings_commit_req = 1;
+    }
+    settings_writing = 0;
+    return;
+  }
+
+  if(settings_commit_req)
+  {
+    settings_commit_req = 0;
+    // all changes made till now go to one record, the image lives only
+    // till settings_log_begin() copies it
+    if(settings_dirty)
+    {
+      uint8_t record[SETTINGS_LOG_PAYLOAD_MAX];
+      uint16_t len = settings_encode(record);
+      if((len != 0U) && (settings_log_begin(record, len, SETS_VERSION) == SETTINGS_LOG_OK))
+      {
+        for(uint8_t i = 0; i < settings_changes_num; ++i)
+          settings_changes[i].writing = 1;
+        settings_writing = settings_dirty;
+        settings_dirty = 0;
+      }
+      else
+      {
+        settings_write_res = SETS_FLASH_FAIL;
+      }
+    }
+  }
+}
+
+settings_err_code_type settings_flush(void)
+{
+  // finish the record being written, a held erase would stop the loop
+  while(settings_log_is_busy())
   {
-    settings.k1_address[index] = val;
-    return settings_write(SETS_MAIN_COPY) | settings_write(SETS_SPARE_COPY);
+    if(flash_async_is_erase_held())
+      return SETS_FLASH_FAIL;
+    settings_handler();
   }
-  else
+  if(settings_dirty)
   {
-    return SETS_ERR;
+    settings_commit();
+    settings_handler();
+    while(settings_log_is_busy())
+    {
+      if(flash_async_is_erase_held())
+        return SETS_FLASH_FAIL;
+      settings_handler();
+    }
   }
+  // a failed write is not retried here, it stays committed
+  return (settings_dirty == 0U) ? settings_write_res : SETS_FLASH_FAIL;
+}
+
+uint32_t settings_get_dirty(void)
+{
+  return settings_dirty | settings_writing;
 }
@@ -0,0 +1,140 @@
+/// *****************************************************************************
+/// @file           : supply.c
+/// @brief          : monitor of the K1 loop supply on v_in_mon
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "supply.h"
+#include "adc-filter.h"
+
+// log2 of ADC_SCAN_BLOCK_SCANS
+#define SUPPLY_BLOCK_LOG2   ADC_FILTER_BLOCK_LOG2
+
+static supply_config_type supply_config = {0};
+static volatile uint8_t supply_ready = 0;
+static volatile supply_state_type supply_state = SUPPLY_UNDEFINED;
+static volatile supply_handler_type supply_handler = 0;
+
+// envelope, min > max means empty
+static volatile uint16_t supply_avg_mv = 0;
+static volatile uint16_t supply_min_mv = UINT16_MAX;
+static volatile uint16_t supply_max_mv = 0;
+// minimum for the health of K1, its own reset by supply_get_health()
+static volatile uint16_t supply_health_mv = UINT16_MAX;
+
+/// @name supply_to_mv
+/// @brief The function converts ADC value to the supply voltage.
+/// @param q15 Q15 of ADC full scale
+/// @return voltage in mV
+static uint16_t supply_to_mv(uint32_t q15)
+{
+  return (uint16_t)((q15 * supply_config.full_scale_mv) >> 15);
+}
+
+SUPPLY_ERR_CODES supply_init(const supply_config_type * config)
+{
+  if((config->full_scale_mv == 0U) || (config->low_mv > config->sag_mv) ||
+     (((uint32_t)config->sag_mv + config->hyst_mv) > config->full_scale_mv))
+    return SUPPLY_ERR;
+  supply_ready = 0;
+  supply_config = *config;
+  supply_state = SUPPLY_UNDEFINED;
+  supply_avg_mv = 0;
+  supply_min_mv = UINT16_MAX;
+  supply_max_mv = 0;
+  supply_health_mv = UINT16_MAX;
+  supply_ready = 1U;
+  return SUPPLY_OK;
+}
+
+void supply_set_handler(supply_handler_type handler)
+{
+  supply_handler = handler;
+}
+
+void supply_block_isr(const adc_scan_block_type * block)
+{
+  if(!supply_ready)
+    return;
+
+  // fast value: mean of the block
+  uint32_t sum = 0;
+  for(uint8_t i = 0; i < ADC_SCAN_BLOCK_SCANS; ++i)
+    sum += block->sample[i][ADC_SCAN_V_IN];
+  // the sum of 2^3 samples of 12 bits is Q15 of the mean, with the gain
+  // correction of adc-filter
+  uint32_t fast_q15 = ((sum << (3U - SUPPLY_BLOCK_LOG2)) * adc_filter_get_gain()) >> ADC_FILTER_GAIN_SHIFT;
+  uint16_t fast_mv = supply_to_mv(fast_q15);
+  if(fast_mv < supply_min_mv)
+    supply_min_mv = fast_mv;
+  if(fast_mv > supply_max_mv)
+    supply_max_mv = fast_mv;
+  if(fast_mv < supply_health_mv)
+    supply_health_mv = fast_mv;
+
+  // average: adc-filter, the block mean till its first output
+  uint16_t avg_mv = fast_mv;
+  if(adc_filter_get_outputs(ADC_SCAN_V_IN) != 0U)
+    avg_mv = supply_to_mv((uint16_t)adc_filter_get_q15(ADC_SCAN_V_IN));
+  supply_avg_mv = avg_mv;
+
+  // sag and low come at once, norm waits for the average
+  supply_state_type state = supply_state;
+  if(fast_mv < supply_config.low_mv)
+    state = SUPPLY_LOW;
+  else if((state != SUPPLY_LOW) && (fast_mv < supply_config.sag_mv))
+    state = SUPPLY_SAG;
+  else if((state == SUPPLY_UNDEFINED) ||
+          ((state != SUPPLY_NORM) && (fast_mv >= supply_config.sag_mv) &&
+           (avg_mv >= (supply_config.sag_mv + supply_config.hyst_mv))))
+    state = SUPPLY_NORM;
+  else if((state == SUPPLY_LOW) && (avg_mv >= (supply_config.low_mv + supply_config.hyst_mv)))
+    state = SUPPLY_SAG;
+  if(state == supply_state)
+    return;
+  supply_state = state;
+  supply_handler_type handler = supply_handler;
+  if(handler != 0)
+    handler(state);
+}
+
+supply_state_type supply_get_state(void)
+{
+  return supply_state;
+}
+
+void supply_get_envelope(supply_envelope_type * env)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  env->avg_mv = supply_avg_mv;
+  env->min_mv = supply_min_mv;
+  env->max_mv = supply_max_mv;
+  supply_min_mv = UINT16_MAX;
+  supply_max_mv = 0;
+  __set_PRIMASK(primask);
+  // no block since the last reset
+  if(env->min_mv > env->max_mv)
+  {
+    env->min_mv = env->avg_mv;
+    env->max_mv = env->avg_mv;
+  }
+}
+
+uint8_t supply_get_health(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint16_t min_mv = supply_health_mv;
+  supply_health_mv = UINT16_MAX;
+  __set_PRIMASK(primask);
+  // no block since the last call
+  if(min_mv == UINT16_MAX)
+    min_mv = supply_avg_mv;
+  uint32_t health = (min_mv + 50U) / 100U;
+  return (health > UINT8_MAX) ? UINT8_MAX : (uint8_t)health;
+}
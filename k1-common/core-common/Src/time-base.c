@@ -0,0 +1,81 @@
+/// *****************************************************************************
+/// @file           : time-base.c
+/// @brief          : 64-bit monotonic time base (SysTick)
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include "time-base.h"
+
+// fraction of 1 us of the SysTick cycles
+#define TIME_BASE_US_SHIFT  22U
+
+// number of SysTick wraps, counted by the first one who sees COUNTFLAG
+static volatile uint64_t time_base_ticks = 0;
+
+// us per SysTick cycle << TIME_BASE_US_SHIFT, (LOAD + 1) * mult < 2^32
+static uint32_t time_base_us_mult = 0;
+
+/// @name time_base_sync
+/// @brief The function counts the wrap of SysTick and reads its counter,
+/// @brief the interrupts must be masked.
+/// @param val pointer to store SysTick->VAL after the counted wraps
+/// @return number of SysTick wraps
+static uint64_t time_base_sync(uint32_t * val)
+{
+  // COUNTFLAG is cleared by the read: every wrap is counted once, by the
+  // tick interrupt or by a reader which comes before it
+  uint32_t v = SysTick->VAL;
+  if(SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk)
+  {
+    ++time_base_ticks;
+    v = SysTick->VAL;
+  }
+  *val = v;
+  return time_base_ticks;
+}
+
+void time_base_init(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  time_base_us_mult = (1000UL << TIME_BASE_US_SHIFT) / (SysTick->LOAD + 1U);
+  (void)SysTick->CTRL;
+  time_base_ticks = 0;
+  __set_PRIMASK(primask);
+}
+
+uint64_t time_base_ms(void)
+{
+  // 64-bit value is read by 2 accesses, SysTick must not change it between
+  uint32_t val;
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint64_t ret_val = time_base_sync(&val);
+  __set_PRIMASK(primask);
+  return ret_val;
+}
+
+uint64_t time_base_us(void)
+{
+  uint32_t val;
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint64_t ticks = time_base_sync(&val);
+  uint32_t load = SysTick->LOAD;
+  __set_PRIMASK(primask);
+  // SysTick counts down from LOAD, one wrap per ms
+  return ticks * 1000U + (((load - val) * time_base_us_mult) >> TIME_BASE_US_SHIFT);
+}
+
+void time_base_tick_isr(void)
+{
+  uint32_t val;
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  (void)time_base_sync(&val);
+  __set_PRIMASK(primask);
+}
@@ -0,0 +1,101 @@
+/// *****************************************************************************
+/// @file           : hal-fake.h
+/// @brief          : host fakes of STM32F1 HAL for the K1 loop simulator
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// The sources of k1-common are built for the host with the real HAL headers.
+/// The fakes stand in for the HAL functions they call, peripheral registers
+/// are plain structures in RAM which the handles point to. DMA channels keep
+/// their addresses in CPAR/CMAR as on the MCU, so the simulator is linked as
+/// non-PIE: static buffers stay below 4GB and survive the uint32_t casts.
+/// The flash of the MCU is mapped at its real address. The time base runs
+/// from the virtual time instead of SysTick.
+///
+/// Interrupts are raised by calling the HAL callbacks, which the simulator
+/// implements the same way as the CubeMX periphery files of the device.
+
+#ifndef INC_HAL_FAKE_H_
+#define INC_HAL_FAKE_H_
+
+#include "main.h"
+
+/// bit time of K1 UART, us
+#define HAL_FAKE_UART_BIT_US   (1000000.0 / 115200.0)
+
+/// peripherals of the device
+extern TIM_HandleTypeDef htim1;
+extern TIM_HandleTypeDef htim4;
+extern UART_HandleTypeDef huart2;
+
+/// @name hal_fake_init
+/// @brief The function maps the flash, links handles to the fake registers
+/// @brief and resets the virtual time.
+/// @return 0 - OK, 1 - flash can not be mapped
+uint8_t hal_fake_init(void);
+
+/// Virtual time of the simulation
+/// @return time in us
+double hal_fake_time_us(void);
+
+/// Move the virtual time forward
+/// @param us time step in us
+void hal_fake_advance_us(double us);
+
+/// Move the virtual time back to replay an interval for another device of
+/// the shared stack, nothing may be scheduled in the interval
+/// @param time_us start of the interval, hal_fake_time_us() before it
+void hal_fake_rewind_us(double time_us);
+
+/// Set the level of the input pin read by HAL_GPIO_ReadPin, a change calls
+/// HAL_GPIO_EXTI_Callback
+/// @param port GPIO port
+/// @param pin GPIO_PIN_x
+/// @param state level of the pin
+void hal_fake_gpio_set(GPIO_TypeDef * port, uint16_t pin, GPIO_PinState state);
+
+/// @name hal_fake_uart_rx
+/// @brief The function puts bytes on the Rx line: DMA writes them to the
+/// @brief reception buffer, half/complete and IDLE events are raised.
+/// @param huart UART with reception started by HAL_UARTEx_ReceiveToIdle_DMA
+/// @param bytes bytes of the burst
+/// @param len number of bytes
+void hal_fake_uart_rx(UART_HandleTypeDef * huart, const uint8_t * bytes, uint16_t len);
+
+/// @name hal_fake_pwm_out
+/// @brief The function runs the update DMA of the timer and collects pulse
+/// @brief widths of CH1: CCR1, then every value loaded by DMA. The DMA
+/// @brief transfer complete callback is raised at the end.
+/// @param htim timer with CH1 in PWM mode
+/// @param widths buffer for pulse widths, us
+/// @param size size of the buffer
+/// @return number of pulses till the first idle (0 width) symbol
+uint16_t hal_fake_pwm_out(TIM_HandleTypeDef * htim, uint16_t * widths, uint16_t size);
+
+/// @name hal_fake_pwm_in
+/// @brief The function feeds pulses to the timer in PWM input mode: the
+/// @brief first edge raises CH1 capture, every falling edge makes the DMA
+/// @brief burst of CCR1/CCR2 on CH2, the quiet line raises the update.
+/// @param htim timer in PWM input mode with CH2 DMA linked
+/// @param widths pulse widths, us
+/// @param num number of pulses
+/// @param period_us period of the pulses
+void hal_fake_pwm_in(TIM_HandleTypeDef * htim, const uint16_t * widths, uint16_t num, uint16_t period_us);
+
+/// @name hal_fake_pwm_in_edges
+/// @brief The function feeds pulses as hal_fake_pwm_in(), every rising edge
+/// @brief has its own distance from the previous one (glitches).
+/// @param htim timer in PWM input mode with CH2 DMA linked
+/// @param periods distance of the edge from the previous one, us, the first
+/// @param         one is not used; 0 - period_us for all edges
+/// @param widths pulse widths, us
+/// @param num number of pulses
+/// @param period_us period of the pulses without periods
+void hal_fake_pwm_in_edges(TIM_HandleTypeDef * htim, const uint16_t * periods, const uint16_t * widths,
+                           uint16_t num, uint16_t period_us);
+
+#endif // #ifndef INC_HAL_FAKE_H_
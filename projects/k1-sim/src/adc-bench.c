@@ -0,0 +1,129 @@
+/// *****************************************************************************
+/// @file           : adc-bench.c
+/// @brief          : host benchmark of the ADC filter bank
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// The blocks of adc_scan are generated from a constant input with gaussian
+/// noise and quantized to 12 bits, then adc-filter runs on them with
+/// several decimations. For every setting the benchmark reports the time
+/// and the host CPU cycles per input sample, the rms noise of the output
+/// (the noise floor) in LSB of 12 bit ADC and the effective resolution.
+/// The cycles are of the host CPU, on Cortex-M3 they are only comparable
+/// between the settings.
+///
+/// Usage: adc-bench [input noise rms, LSB]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "adc-filter.h"
+
+#define ADC_BENCH_BLOCKS        (1U << 16)
+// outputs skipped while IIR settles, per its time constant
+#define ADC_BENCH_SETTLE        8U
+#define ADC_BENCH_INPUT_LSB     1234.37
+#define ADC_BENCH_NOISE_LSB     1.0
+
+// settings of the benchmark
+static const adc_filter_config_type ADC_BENCH_CONFIGS[] =
+{
+  {3U, 0U}, {5U, 0U}, {7U, 0U}, {9U, 0U}, {7U, 2U}, {7U, 4U}, {11U, 0U}
+};
+
+/// @name adc_bench_gauss
+/// @brief The function returns a gaussian random value (Box-Muller).
+/// @return value with rms 1
+static double adc_bench_gauss(void)
+{
+  double u1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+  double u2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+  return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/// @name adc_bench_cycles
+/// @brief The function reads the cycle counter of the host CPU.
+/// @return cycles, 0 - no counter
+static uint64_t adc_bench_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+int main(int argc, char * argv[])
+{
+  double noise = (argc > 1) ? atof(argv[1]) : ADC_BENCH_NOISE_LSB;
+  static adc_scan_block_type blocks[ADC_BENCH_BLOCKS];
+
+  // input: constant with noise, 12 bit samples
+  srand(1);
+  for(uint32_t b = 0; b < ADC_BENCH_BLOCKS; ++b)
+  {
+    for(uint32_t i = 0; i < ADC_SCAN_BLOCK_SCANS; ++i)
+    {
+      for(uint32_t ch = 0; ch < ADC_SCAN_CHANNELS; ++ch)
+      {
+        long v = lround(ADC_BENCH_INPUT_LSB + noise * adc_bench_gauss());
+        blocks[b].sample[i][ch] = (uint16_t)((v < 0) ? 0 : ((v > 4095) ? 4095 : v));
+      }
+    }
+  }
+
+  printf("input %.2f LSB, noise %.2f LSB rms, %u channels\n", ADC_BENCH_INPUT_LSB, noise,
+         (unsigned)ADC_SCAN_CHANNELS);
+  printf("osr   iir   ns/sample  cycles/sample  outputs  mean, LSB   noise, LSB rms  bits\n");
+  for(uint32_t c = 0; c < (sizeof(ADC_BENCH_CONFIGS) / sizeof(ADC_BENCH_CONFIGS[0])); ++c)
+  {
+    adc_filter_config_type config[ADC_SCAN_CHANNELS];
+    for(uint32_t ch = 0; ch < ADC_SCAN_CHANNELS; ++ch)
+      config[ch] = ADC_BENCH_CONFIGS[c];
+    adc_filter_init(config);
+
+    // statistics of the outputs of channel 0
+    double sum = 0;
+    double sum2 = 0;
+    uint32_t num = 0;
+    uint32_t seen = 0;
+    struct timespec t0;
+    struct timespec t1;
+    uint64_t cycles = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for(uint32_t b = 0; b < ADC_BENCH_BLOCKS; ++b)
+    {
+      uint64_t c0 = adc_bench_cycles();
+      adc_filter_block(&blocks[b]);
+      cycles += adc_bench_cycles() - c0;
+      uint32_t outputs = adc_filter_get_outputs(ADC_SCAN_V_IN);
+      if((outputs != seen) && (outputs > (ADC_BENCH_SETTLE << config[0].iir_shift)))
+      {
+        double v = adc_filter_get_q31(ADC_SCAN_V_IN) / 2147483648.0 * 4096.0;
+        sum += v;
+        sum2 += v * v;
+        ++num;
+      }
+      seen = outputs;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double samples = (double)ADC_BENCH_BLOCKS * ADC_SCAN_BLOCK_SCANS * ADC_SCAN_CHANNELS;
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / samples;
+    double mean = (num > 0U) ? (sum / num) : 0;
+    double rms = (num > 1U) ? sqrt(fmax(sum2 / num - mean * mean, 0)) : 0;
+    // resolution: 12 bits less the bits of the noise over the quantization
+    double bits = (rms > 0) ? (12.0 - log2(rms / (1.0 / sqrt(12.0)))) : 0;
+    printf("%-5u %-5u %-10.2f %-14.2f %-8u %-11.3f %-15.4f %.1f\n", 1U << config[0].osr_log2,
+           config[0].iir_shift, ns, cycles / samples, num, mean, rms, bits);
+  }
+  return 0;
+}
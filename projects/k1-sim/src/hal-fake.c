@@ -0,0 +1,445 @@
+/// *****************************************************************************
+/// @file           : hal-fake.c
+/// @brief          : host fakes of STM32F1 HAL for the K1 loop simulator
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+#include <string.h>
+#include <sys/mman.h>
+#include "hal-fake.h"
+#include "time-base.h"
+
+/// flash of STM32F103C8
+#define HAL_FAKE_FLASH_SIZE    0x10000U
+#define HAL_FAKE_FLASH_PAGE    0x400U
+
+// DMA channel, keeps the length of the transfer for the memory pointer
+typedef struct
+{
+  DMA_Channel_TypeDef regs;
+  uint32_t len;
+} hal_fake_dma_channel_type;
+
+// fake registers
+static TIM_TypeDef hal_fake_tim1;
+static TIM_TypeDef hal_fake_tim4;
+static USART_TypeDef hal_fake_usart2;
+static hal_fake_dma_channel_type hal_fake_dma_ch4;
+static hal_fake_dma_channel_type hal_fake_dma_ch5;
+static hal_fake_dma_channel_type hal_fake_dma_ch6;
+
+// handles of the device
+TIM_HandleTypeDef htim1;
+TIM_HandleTypeDef htim4;
+UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_tim1_up;
+DMA_HandleTypeDef hdma_tim4_ch2;
+DMA_HandleTypeDef hdma_usart2_rx;
+
+// virtual time, us
+static double hal_fake_us = 0;
+
+// input levels of GPIOA..GPIOD, 1 - high
+static uint16_t hal_fake_gpio[4] = {0xFFFFU, 0xFFFFU, 0xFFFFU, 0xFFFFU};
+
+static uint8_t hal_fake_flash_locked = 1;
+// flash operation started by _IT function: 0 - none, 1 - done, 2 - error
+static uint8_t hal_fake_flash_op = 0;
+
+/// @name hal_fake_dma_setup
+/// @brief The function links the DMA handle to the fake channel.
+static void hal_fake_dma_setup(DMA_HandleTypeDef * hdma, hal_fake_dma_channel_type * ch,
+                               uint32_t direction, uint32_t mode, void * parent)
+{
+  memset(ch, 0, sizeof(*ch));
+  memset(hdma, 0, sizeof(*hdma));
+  hdma->Instance = &ch->regs;
+  hdma->Init.Direction = direction;
+  hdma->Init.Mode = mode;
+  hdma->State = HAL_DMA_STATE_READY;
+  hdma->Parent = parent;
+}
+
+/// @name hal_fake_dma_mem
+/// @brief The function returns the memory address of the next transfer.
+static void * hal_fake_dma_mem(DMA_HandleTypeDef * hdma, uint32_t item_size)
+{
+  hal_fake_dma_channel_type * ch = (hal_fake_dma_channel_type *)hdma->Instance;
+  return (uint8_t *)(uintptr_t)ch->regs.CMAR + (ch->len - ch->regs.CNDTR) * item_size;
+}
+
+/// @name hal_fake_gpio_idx
+/// @brief The function returns index of the GPIO port.
+static uint8_t hal_fake_gpio_idx(GPIO_TypeDef * port)
+{
+  if(port == GPIOA)
+    return 0;
+  if(port == GPIOB)
+    return 1;
+  if(port == GPIOC)
+    return 2;
+  return 3;
+}
+
+uint8_t hal_fake_init(void)
+{
+  void * flash = mmap((void *)FLASH_BASE, HAL_FAKE_FLASH_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+  if(flash != (void *)FLASH_BASE)
+    return 1U;
+  memset(flash, 0xFF, HAL_FAKE_FLASH_SIZE);
+
+  memset(&hal_fake_tim1, 0, sizeof(hal_fake_tim1));
+  memset(&hal_fake_tim4, 0, sizeof(hal_fake_tim4));
+  memset(&hal_fake_usart2, 0, sizeof(hal_fake_usart2));
+
+  memset(&htim1, 0, sizeof(htim1));
+  htim1.Instance = &hal_fake_tim1;
+  hal_fake_tim1.ARR = 0xFFFFU;
+  hal_fake_dma_setup(&hdma_tim1_up, &hal_fake_dma_ch5, DMA_MEMORY_TO_PERIPH, DMA_NORMAL, &htim1);
+  htim1.hdma[TIM_DMA_ID_UPDATE] = &hdma_tim1_up;
+
+  memset(&htim4, 0, sizeof(htim4));
+  htim4.Instance = &hal_fake_tim4;
+  hal_fake_tim4.ARR = 299U; // as MX_TIM4_Init
+  hal_fake_dma_setup(&hdma_tim4_ch2, &hal_fake_dma_ch4, DMA_PERIPH_TO_MEMORY, DMA_NORMAL, &htim4);
+  htim4.hdma[TIM_DMA_ID_CC2] = &hdma_tim4_ch2;
+
+  memset(&huart2, 0, sizeof(huart2));
+  huart2.Instance = &hal_fake_usart2;
+  hal_fake_dma_setup(&hdma_usart2_rx, &hal_fake_dma_ch6, DMA_PERIPH_TO_MEMORY, DMA_CIRCULAR, &huart2);
+  huart2.hdmarx = &hdma_usart2_rx;
+
+  hal_fake_us = 0;
+  return 0U;
+}
+
+double hal_fake_time_us(void)
+{
+  return hal_fake_us;
+}
+
+void hal_fake_advance_us(double us)
+{
+  hal_fake_us += us;
+}
+
+void hal_fake_rewind_us(double time_us)
+{
+  if(time_us < hal_fake_us)
+    hal_fake_us = time_us;
+}
+
+void hal_fake_gpio_set(GPIO_TypeDef * port, uint16_t pin, GPIO_PinState state)
+{
+  uint8_t idx = hal_fake_gpio_idx(port);
+  uint16_t prev = hal_fake_gpio[idx];
+  if(state == GPIO_PIN_SET)
+    hal_fake_gpio[idx] |= pin;
+  else
+    hal_fake_gpio[idx] &= (uint16_t)~pin;
+  // EXTI on both edges
+  if(hal_fake_gpio[idx] != prev)
+    HAL_GPIO_EXTI_Callback(pin);
+}
+
+void hal_fake_uart_rx(UART_HandleTypeDef * huart, const uint8_t * bytes, uint16_t len)
+{
+  DMA_HandleTypeDef * hdma = huart->hdmarx;
+  DMA_Channel_TypeDef * ch = hdma->Instance;
+  uint16_t size = huart->RxXferSize;
+  for(uint16_t i = 0; i < len; ++i)
+  {
+    hal_fake_us += 10.0 * HAL_FAKE_UART_BIT_US;
+    if(!(ch->CCR & DMA_CCR_EN))
+      continue;
+    *(uint8_t *)hal_fake_dma_mem(hdma, 1U) = bytes[i];
+    --ch->CNDTR;
+    if(ch->CNDTR == (size / 2U))
+    {
+      huart->RxEventType = HAL_UART_RXEVENT_HT;
+      HAL_UARTEx_RxEventCallback(huart, size / 2U);
+    }
+    else if(ch->CNDTR == 0U)
+    {
+      ch->CNDTR = size;
+      huart->RxEventType = HAL_UART_RXEVENT_TC;
+      HAL_UARTEx_RxEventCallback(huart, size);
+    }
+  }
+  // IDLE line is detected after one idle character
+  hal_fake_us += 10.0 * HAL_FAKE_UART_BIT_US;
+  if(ch->CCR & DMA_CCR_EN)
+  {
+    huart->RxEventType = HAL_UART_RXEVENT_IDLE;
+    HAL_UARTEx_RxEventCallback(huart, (uint16_t)(size - ch->CNDTR));
+  }
+}
+
+uint16_t hal_fake_pwm_out(TIM_HandleTypeDef * htim, uint16_t * widths, uint16_t size)
+{
+  TIM_TypeDef * tim = htim->Instance;
+  DMA_HandleTypeDef * hdma = htim->hdma[TIM_DMA_ID_UPDATE];
+  DMA_Channel_TypeDef * ch = hdma->Instance;
+  uint16_t n = 0;
+  uint16_t pulses = 0;
+  if(!(tim->CR1 & TIM_CR1_CEN))
+    return 0;
+
+  widths[n++] = (uint16_t)tim->CCR1;
+  while((ch->CCR & DMA_CCR_EN) && (tim->DIER & TIM_DIER_UDE) && (ch->CNDTR != 0U))
+  {
+    uint16_t width = *(uint16_t *)hal_fake_dma_mem(hdma, 2U);
+    --ch->CNDTR;
+    tim->CCR1 = width;
+    if(n < size)
+      widths[n++] = width;
+  }
+  for(pulses = 0; (pulses < n) && (widths[pulses] != 0U); ++pulses)
+  {
+  }
+  hal_fake_us += (double)n * (tim->ARR + 1U);
+
+  ch->CCR &= ~DMA_CCR_EN;
+  hdma->State = HAL_DMA_STATE_READY;
+  if(hdma->XferCpltCallback != 0)
+    hdma->XferCpltCallback(hdma);
+  return pulses;
+}
+
+void hal_fake_pwm_in(TIM_HandleTypeDef * htim, const uint16_t * widths, uint16_t num, uint16_t period_us)
+{
+  hal_fake_pwm_in_edges(htim, 0, widths, num, period_us);
+}
+
+void hal_fake_pwm_in_edges(TIM_HandleTypeDef * htim, const uint16_t * periods, const uint16_t * widths,
+                           uint16_t num, uint16_t period_us)
+{
+  TIM_TypeDef * tim = htim->Instance;
+  DMA_HandleTypeDef * hdma = htim->hdma[TIM_DMA_ID_CC2];
+  DMA_Channel_TypeDef * ch = hdma->Instance;
+  volatile uint32_t * regs = (volatile uint32_t *)tim;
+  uint32_t base = tim->DCR & TIM_DCR_DBA;
+  uint32_t burst = ((tim->DCR & TIM_DCR_DBL) >> TIM_DCR_DBL_Pos) + 1U;
+  if(!(tim->CR1 & TIM_CR1_CEN))
+    return;
+
+  for(uint16_t i = 0; i < num; ++i)
+  {
+    // rising edge: CH1 takes the counter, the slave mode resets it
+    tim->CCR1 = (i == 0U) ? tim->ARR : ((periods != 0) ? periods[i] : period_us);
+    if((i == 0U) && (tim->DIER & TIM_DIER_CC1IE))
+    {
+      htim->Channel = HAL_TIM_ACTIVE_CHANNEL_1;
+      HAL_TIM_IC_CaptureCallback(htim);
+      htim->Channel = HAL_TIM_ACTIVE_CHANNEL_CLEARED;
+    }
+    // falling edge: CH2 takes the width and requests the DMA burst
+    tim->CCR2 = widths[i];
+    if((tim->DIER & TIM_DIER_CC2DE) && (ch->CCR & DMA_CCR_EN))
+    {
+      for(uint32_t k = 0; (k < burst) && (ch->CNDTR != 0U); ++k)
+      {
+        *(uint16_t *)hal_fake_dma_mem(hdma, 2U) = (uint16_t)regs[base + k];
+        --ch->CNDTR;
+      }
+    }
+  }
+  // the line is quiet: the counter overflows
+  hal_fake_us += tim->ARR + 1U;
+  if(tim->DIER & TIM_DIER_UIE)
+  {
+    HAL_TIM_PeriodElapsedCallback(htim);
+  }
+}
+
+uint32_t HAL_GetTick(void)
+{
+  return (uint32_t)(hal_fake_us / 1000.0);
+}
+
+void time_base_init(void)
+{
+}
+
+uint64_t time_base_ms(void)
+{
+  return (uint64_t)(hal_fake_us / 1000.0);
+}
+
+uint64_t time_base_us(void)
+{
+  return (uint64_t)hal_fake_us;
+}
+
+void time_base_tick_isr(void)
+{
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef * GPIOx, uint16_t GPIO_Pin)
+{
+  return (hal_fake_gpio[hal_fake_gpio_idx(GPIOx)] & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+HAL_StatusTypeDef HAL_DMA_Start(DMA_HandleTypeDef * hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength)
+{
+  hal_fake_dma_channel_type * ch = (hal_fake_dma_channel_type *)hdma->Instance;
+  if(hdma->State != HAL_DMA_STATE_READY)
+    return HAL_BUSY;
+  hdma->State = HAL_DMA_STATE_BUSY;
+  if(hdma->Init.Direction == DMA_MEMORY_TO_PERIPH)
+  {
+    ch->regs.CPAR = DstAddress;
+    ch->regs.CMAR = SrcAddress;
+  }
+  else
+  {
+    ch->regs.CPAR = SrcAddress;
+    ch->regs.CMAR = DstAddress;
+  }
+  ch->regs.CNDTR = DataLength;
+  ch->len = DataLength;
+  ch->regs.CCR |= DMA_CCR_EN;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Start_IT(DMA_HandleTypeDef * hdma, uint32_t SrcAddress, uint32_t DstAddress, uint32_t DataLength)
+{
+  return HAL_DMA_Start(hdma, SrcAddress, DstAddress, DataLength);
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef * hdma)
+{
+  if(hdma->State != HAL_DMA_STATE_BUSY)
+    return HAL_ERROR;
+  hdma->Instance->CCR &= ~DMA_CCR_EN;
+  hdma->State = HAL_DMA_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef * huart, uint8_t * pData, uint16_t Size)
+{
+  // a new reception replaces the one stopped by an error
+  HAL_DMA_Abort(huart->hdmarx);
+  huart->pRxBuffPtr = pData;
+  huart->RxXferSize = Size;
+  huart->ReceptionType = HAL_UART_RECEPTION_TOIDLE;
+  return HAL_DMA_Start(huart->hdmarx, (uint32_t)(uintptr_t)&huart->Instance->DR, (uint32_t)(uintptr_t)pData, Size);
+}
+
+HAL_UART_RxEventTypeTypeDef HAL_UARTEx_GetRxEventType(UART_HandleTypeDef * huart)
+{
+  return huart->RxEventType;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Start(TIM_HandleTypeDef * htim, uint32_t Channel)
+{
+  htim->Instance->CCER |= (TIM_CCER_CC1E << Channel);
+  htim->Instance->CR1 |= TIM_CR1_CEN;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+  hal_fake_flash_locked = 0;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+  hal_fake_flash_locked = 1;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+  uint8_t halfwords = (TypeProgram == FLASH_TYPEPROGRAM_HALFWORD) ? 1U :
+                      (TypeProgram == FLASH_TYPEPROGRAM_WORD) ? 2U : 4U;
+  if(hal_fake_flash_locked || (Address < FLASH_BASE) || (Address & 1U) ||
+     ((Address + 2U * halfwords) > (FLASH_BASE + HAL_FAKE_FLASH_SIZE)))
+    return HAL_ERROR;
+  for(uint8_t i = 0; i < halfwords; ++i)
+  {
+    volatile uint16_t * cell = (volatile uint16_t *)(uintptr_t)(Address + 2U * i);
+    uint16_t value = (uint16_t)(Data >> (16U * i));
+    // PGERR: the cell is not erased, only 0 may be written over it
+    if((*cell != 0xFFFFU) && (value != 0U))
+      return HAL_ERROR;
+    *cell = value;
+  }
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef * pEraseInit, uint32_t * PageError)
+{
+  uint32_t addr = pEraseInit->PageAddress & ~(HAL_FAKE_FLASH_PAGE - 1U);
+  *PageError = 0xFFFFFFFFU;
+  if(hal_fake_flash_locked)
+    return HAL_ERROR;
+  for(uint32_t i = 0; i < pEraseInit->NbPages; ++i, addr += HAL_FAKE_FLASH_PAGE)
+  {
+    if((addr < FLASH_BASE) || (addr >= (FLASH_BASE + HAL_FAKE_FLASH_SIZE)))
+    {
+      *PageError = addr;
+      return HAL_ERROR;
+    }
+    memset((void *)(uintptr_t)addr, 0xFF, HAL_FAKE_FLASH_PAGE);
+  }
+  return HAL_OK;
+}
+
+// operations with interrupt are made at once, their end is reported by
+// HAL_FLASH_IRQHandler()
+HAL_StatusTypeDef HAL_FLASH_Program_IT(uint32_t TypeProgram, uint32_t Address, uint64_t Data)
+{
+  if(hal_fake_flash_op != 0U)
+    return HAL_ERROR;
+  hal_fake_flash_op = (HAL_FLASH_Program(TypeProgram, Address, Data) == HAL_OK) ? 1U : 2U;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase_IT(FLASH_EraseInitTypeDef * pEraseInit)
+{
+  uint32_t error = 0;
+  if(hal_fake_flash_op != 0U)
+    return HAL_ERROR;
+  hal_fake_flash_op = (HAL_FLASHEx_Erase(pEraseInit, &error) == HAL_OK) ? 1U : 2U;
+  return HAL_OK;
+}
+
+void HAL_FLASH_IRQHandler(void)
+{
+  uint8_t op = hal_fake_flash_op;
+  hal_fake_flash_op = 0;
+  if(op == 1U)
+    HAL_FLASH_EndOfOperationCallback(0xFFFFFFFFU);
+  else if(op == 2U)
+    HAL_FLASH_OperationErrorCallback(0xFFFFFFFFU);
+}
+
+// the simulator has no interrupt controller, interrupts are polled
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+  (void)IRQn;
+  (void)PreemptPriority;
+  (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+  (void)IRQn;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+  (void)IRQn;
+}
+
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+  (void)IRQn;
+}
@@ -0,0 +1,372 @@
+/// *****************************************************************************
+/// @file           : k1-sim.c
+/// @brief          : K1 loop simulator with virtual devices (Linux host)
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// The emulated pult at SETS_K1_ADDR_PULT polls every device of the loop in
+/// turn and decodes the replies. The devices run the K1 stack of k1-common
+/// (k1-rx, k1-frame, k1-tx, k1-capture, k1-addr) on top of the HAL fakes,
+/// the pult decodes the reply pulses by k1-capture as well.
+///
+/// The stack keeps its state in static variables, so the devices share it:
+/// before every poll the addressed device is loaded (its address and its
+/// armed reply). Every request is heard first by a device which is not
+/// addressed, the next address of the loop: it must drop the request in the
+/// address filter and must not reply. The bus time of the request is then
+/// replayed for the addressed device. After every poll the device runs its
+/// main loop: received frames are processed, the reply is armed again.
+///
+/// Every K1_SIM_GLITCH_POLLS-th reply gets a noise glitch between two
+/// symbols, the pult must skip it and decode the frame.
+///
+/// Alarms are raised at random devices at random moments, the state byte of
+/// the reply becomes K1_SIM_STATE_ALARM. The latency is counted from the
+/// alarm to the decoding of the reply by the pult.
+///
+/// Usage: k1-sim [devices 1..254] [poll cycles]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "hal-fake.h"
+#include "buttons.h"
+#include "crc32.h"
+#include "device-config.h"
+#include "flash-async.h"
+#include "k1-addr.h"
+#include "k1-capture.h"
+#include "k1-frame.h"
+#include "k1-phy.h"
+#include "k1-rx.h"
+#include "k1-tx.h"
+#include "settings.h"
+#include "time-base.h"
+
+#define K1_SIM_DEVICES_MAX       (SETS_K1_ADDR_MAX - SETS_K1_ADDR_MIN + 1U)
+#define K1_SIM_CYCLES_DEFAULT    100U
+/// the pult waits for the reply so long after the request
+#define K1_SIM_REPLY_TIMEOUT_US  (K1_PHY_TURNAROUND_US + K1_PHY_FRAME_GAP_US)
+/// mean period of alarms in the loop
+#define K1_SIM_ALARM_PERIOD_US   100000.0
+/// replies with a glitch on the line
+#define K1_SIM_GLITCH_POLLS      7U
+#define K1_SIM_GLITCH_US         2U
+
+/// states in the reply
+#define K1_SIM_STATE_NORMAL      0U
+#define K1_SIM_STATE_ALARM       1U
+
+// virtual device
+typedef struct
+{
+  uint8_t addr;
+  uint8_t state;        // state of the item now
+  uint8_t armed_state;  // state in the reply armed by the main loop
+  double alarm_us;      // time of the alarm not seen by the pult, <0 - none
+} k1_sim_device_type;
+
+// results of the run
+typedef struct
+{
+  uint32_t polls;
+  uint32_t replies;
+  uint32_t lost;
+  uint32_t bad;
+  uint32_t frames;
+  uint32_t alarms;
+  uint32_t glitches;
+  uint32_t overheard;   // requests heard by a device which is not addressed
+  uint32_t answered;    // ... which it has not dropped
+  double cycle_max_us;
+  double latency_max_us;
+  double latency_sum_us;
+} k1_sim_stats_type;
+
+static k1_sim_device_type k1_sim_devices[K1_SIM_DEVICES_MAX];
+static k1_sim_stats_type k1_sim_stats = {0};
+
+// next update of the buttons, UINT64_MAX - idle
+static uint64_t k1_sim_buttons_ms = UINT64_MAX;
+
+// repeatable pseudo random sequence
+static uint32_t k1_sim_seed = 1U;
+
+/// @name k1_sim_rand
+/// @return pseudo random value [0 - 1)
+static double k1_sim_rand(void)
+{
+  k1_sim_seed = k1_sim_seed * 1664525U + 1013904223U;
+  return (double)(k1_sim_seed >> 8) / (double)(1U << 24);
+}
+
+/// USART2 Rx event, as in usart.c of the device
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef * huart, uint16_t Size)
+{
+  if(huart == &huart2)
+  {
+    k1_rx_event_isr(Size, (HAL_UARTEx_GetRxEventType(huart) == HAL_UART_RXEVENT_IDLE) ? 1U : 0U);
+  }
+}
+
+/// TIM4 update, as in tim.c of the device
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef * htim)
+{
+  if(htim == &htim4)
+  {
+    k1_cap_frame_end_isr();
+  }
+}
+
+/// TIM4 CH1 capture, as in tim.c of the device
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef * htim)
+{
+  if((htim == &htim4) && (htim->Channel == HAL_TIM_ACTIVE_CHANNEL_1))
+  {
+    k1_cap_frame_start_isr();
+  }
+}
+
+/// EXTI edge, as in gpio.c of the device
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  buttons_exti_isr(GPIO_Pin);
+}
+
+/// edge of the buttons, as main_buttons_edge_isr() of the device
+static void k1_sim_buttons_edge_isr(void)
+{
+  k1_sim_buttons_ms = time_base_ms();
+}
+
+void Error_Handler(void)
+{
+  fprintf(stderr, "Error_Handler\n");
+  exit(1);
+}
+
+/// @name k1_sim_device_enter
+/// @brief The function loads the device into the K1 stack.
+/// @param dev virtual device
+static void k1_sim_device_enter(const k1_sim_device_type * dev)
+{
+  k1_addr_set(dev->addr, 0);
+  k1_tx_arm(0, K1_FRAME_CMD_STATE, &dev->armed_state, sizeof(dev->armed_state));
+}
+
+/// @name k1_sim_device_loop
+/// @brief The function runs the main loop of the device once.
+/// @param dev virtual device
+static void k1_sim_device_loop(k1_sim_device_type * dev)
+{
+  k1_rx_frame_type k1_raw;
+  while(k1_rx_frame_peek(&k1_raw))
+  {
+    k1_frame_type k1_frame;
+    k1_frame_parse(&k1_raw, &k1_frame);
+    k1_rx_frame_release();
+  }
+  if(!k1_tx_is_armed(0))
+  {
+    dev->armed_state = dev->state;
+    k1_tx_arm(0, K1_FRAME_CMD_STATE, &dev->armed_state, sizeof(dev->armed_state));
+  }
+}
+
+/// @name k1_sim_poll
+/// @brief The function makes one request of the pult and takes the reply.
+/// @param dev virtual device
+static void k1_sim_poll(k1_sim_device_type * dev)
+{
+  uint8_t req[K1_FRAME_HDR_LEN + K1_FRAME_CRC_LEN];
+  uint16_t widths[K1_TX_SYMBOLS_MAX + 1U];
+  uint16_t periods[K1_TX_SYMBOLS_MAX + 1U];
+  uint8_t reply[K1_CAP_FRAME_MAX_LEN];
+
+  uint16_t len = k1_frame_build(req, dev->addr, SETS_K1_ADDR_PULT, K1_FRAME_CMD_POLL, 0, 0);
+
+  // a device with another address hears the request at the same time
+  k1_sim_device_type listener = {(dev->addr < SETS_K1_ADDR_MAX) ? (uint8_t)(dev->addr + 1U) : SETS_K1_ADDR_MIN,
+                                 K1_SIM_STATE_NORMAL, K1_SIM_STATE_NORMAL, -1};
+  double request_us = hal_fake_time_us();
+  uint64_t start_us;
+  k1_rx_frame_type dropped;
+  k1_sim_device_enter(&listener);
+  uint32_t started = k1_tx_get_started(0, &start_us);
+  hal_fake_uart_rx(&huart2, req, len);
+  ++k1_sim_stats.overheard;
+  if(k1_rx_frame_peek(&dropped) || (k1_tx_get_started(0, &start_us) != started))
+  {
+    ++k1_sim_stats.answered;
+    while(k1_rx_frame_peek(&dropped))
+      k1_rx_frame_release();
+    hal_fake_pwm_out(&htim1, widths, K1_TX_SYMBOLS_MAX);
+  }
+  hal_fake_rewind_us(request_us);
+
+  k1_sim_device_enter(dev);
+  hal_fake_uart_rx(&huart2, req, len);
+  ++k1_sim_stats.polls;
+  ++k1_sim_stats.frames;
+
+  // the reply is started by TIM1 after the turnaround
+  hal_fake_advance_us(K1_PHY_TURNAROUND_US);
+  uint16_t pulses = hal_fake_pwm_out(&htim1, widths, K1_TX_SYMBOLS_MAX);
+  if((pulses > 2U) && ((k1_sim_stats.polls % K1_SIM_GLITCH_POLLS) == 0U))
+  {
+    // the glitch in the low part of a random symbol splits its period
+    uint16_t at = (uint16_t)(1U + k1_sim_rand() * (pulses - 2U));
+    uint16_t offset = (uint16_t)((widths[at] + K1_PHY_BIT_PERIOD_US) / 2U);
+    for(uint16_t i = 0; i < pulses; ++i)
+      periods[i] = K1_PHY_BIT_PERIOD_US;
+    for(uint16_t i = pulses; i > at + 1U; --i)
+    {
+      widths[i] = widths[i - 1U];
+      periods[i] = periods[i - 1U];
+    }
+    widths[at + 1U] = K1_SIM_GLITCH_US;
+    periods[at + 1U] = offset;
+    periods[at + 2U] = (uint16_t)(K1_PHY_BIT_PERIOD_US - offset);
+    hal_fake_pwm_in_edges(&htim4, periods, widths, (uint16_t)(pulses + 1U), K1_PHY_BIT_PERIOD_US);
+    ++k1_sim_stats.glitches;
+  }
+  else if(pulses > 0U)
+    hal_fake_pwm_in(&htim4, widths, pulses, K1_PHY_BIT_PERIOD_US);
+  else
+    hal_fake_advance_us(K1_SIM_REPLY_TIMEOUT_US - K1_PHY_TURNAROUND_US);
+
+  k1_sim_device_loop(dev);
+
+  uint8_t n = k1_cap_frame_get(reply, sizeof(reply));
+  if(n == 0U)
+  {
+    ++k1_sim_stats.lost;
+    return;
+  }
+  ++k1_sim_stats.frames;
+
+  k1_rx_frame_type raw = {reply, 0, n};
+  k1_frame_type frame;
+  if((k1_frame_parse(&raw, &frame) != K1_FRAME_OK) || (frame.dst != SETS_K1_ADDR_PULT) ||
+     (frame.src != dev->addr) || (frame.cmd != K1_FRAME_CMD_STATE) || (frame.len != 1U))
+  {
+    ++k1_sim_stats.bad;
+    return;
+  }
+  ++k1_sim_stats.replies;
+
+  // the pult has seen the alarm and resets the item
+  if((k1_frame_payload_byte(&frame, 0) == K1_SIM_STATE_ALARM) && (dev->alarm_us >= 0))
+  {
+    double latency = hal_fake_time_us() - dev->alarm_us;
+    if(latency > k1_sim_stats.latency_max_us)
+      k1_sim_stats.latency_max_us = latency;
+    k1_sim_stats.latency_sum_us += latency;
+    ++k1_sim_stats.alarms;
+    dev->alarm_us = -1;
+    dev->state = K1_SIM_STATE_NORMAL;
+  }
+}
+
+int main(int argc, char ** argv)
+{
+  uint32_t devices = (argc > 1) ? (uint32_t)strtoul(argv[1], 0, 0) : K1_SIM_DEVICES_MAX;
+  uint32_t cycles = (argc > 2) ? (uint32_t)strtoul(argv[2], 0, 0) : K1_SIM_CYCLES_DEFAULT;
+  if((devices == 0U) || (devices > K1_SIM_DEVICES_MAX) || (cycles == 0U))
+  {
+    fprintf(stderr, "usage: %s [devices 1..%u] [poll cycles]\n", argv[0], K1_SIM_DEVICES_MAX);
+    return 2;
+  }
+  if(hal_fake_init() != 0U)
+  {
+    fprintf(stderr, "flash can not be mapped at 0x%08X\n", (unsigned)FLASH_BASE);
+    return 1;
+  }
+
+  // the device, as in main.c: CRC in software, no CRC unit on the host
+  crc32_init(0);
+  flash_async_init();
+  settings_init();
+  buttons_init();
+  buttons_set_edge_handler(k1_sim_buttons_edge_isr);
+  k1_tx_init(&htim1);
+  k1_rx_set_filter(k1_frame_addr_match);
+  k1_rx_set_end_handler(k1_tx_request_end_isr);
+  k1_rx_init(&huart2);
+  k1_cap_init(&htim4);
+
+  for(uint32_t i = 0; i < devices; ++i)
+  {
+    k1_sim_devices[i].addr = (uint8_t)(SETS_K1_ADDR_MIN + i);
+    k1_sim_devices[i].state = K1_SIM_STATE_NORMAL;
+    k1_sim_devices[i].armed_state = K1_SIM_STATE_NORMAL;
+    k1_sim_devices[i].alarm_us = -1;
+  }
+
+  double next_alarm_us = k1_sim_rand() * 2.0 * K1_SIM_ALARM_PERIOD_US;
+  clock_t host_start = clock();
+  for(uint32_t cycle = 0; cycle < cycles; ++cycle)
+  {
+    double cycle_start_us = hal_fake_time_us();
+    for(uint32_t i = 0; i < devices; ++i)
+    {
+      // alarms which have happened till now
+      while(next_alarm_us <= hal_fake_time_us())
+      {
+        k1_sim_device_type * dev = &k1_sim_devices[(uint32_t)(k1_sim_rand() * devices)];
+        if(dev->alarm_us < 0)
+        {
+          dev->state = K1_SIM_STATE_ALARM;
+          dev->alarm_us = next_alarm_us;
+        }
+        next_alarm_us += k1_sim_rand() * 2.0 * K1_SIM_ALARM_PERIOD_US;
+      }
+      // buttons of the device, idle without edges
+      if(time_base_is_expired(k1_sim_buttons_ms))
+      {
+        buttons_handler();
+        uint32_t next_ms = buttons_get_next_ms();
+        k1_sim_buttons_ms = (next_ms != 0U) ? (time_base_ms() + next_ms) : UINT64_MAX;
+      }
+      k1_sim_poll(&k1_sim_devices[i]);
+    }
+    double cycle_us = hal_fake_time_us() - cycle_start_us;
+    if(cycle_us > k1_sim_stats.cycle_max_us)
+      k1_sim_stats.cycle_max_us = cycle_us;
+  }
+  double host_s = (double)(clock() - host_start) / CLOCKS_PER_SEC;
+  double total_s = hal_fake_time_us() / 1e6;
+
+  k1_rx_stats_type rx;
+  k1_tx_stats_type tx;
+  k1_cap_stats_type cap;
+  k1_rx_get_stats(&rx);
+  k1_tx_get_stats(&tx);
+  k1_cap_get_stats(&cap);
+
+  printf("devices             : %u\n", devices);
+  printf("poll cycles         : %u\n", cycles);
+  printf("poll cycle, ms      : mean %.2f, max %.2f\n",
+         total_s * 1e3 / cycles, k1_sim_stats.cycle_max_us / 1e3);
+  printf("frames per second   : %.1f\n", k1_sim_stats.frames / total_s);
+  printf("replies             : %u of %u, lost %u, bad %u\n",
+         k1_sim_stats.replies, k1_sim_stats.polls, k1_sim_stats.lost, k1_sim_stats.bad);
+  if(k1_sim_stats.alarms > 0U)
+  {
+    printf("alarm latency, ms   : mean %.2f, worst %.2f (%u alarms)\n",
+           k1_sim_stats.latency_sum_us / k1_sim_stats.alarms / 1e3,
+           k1_sim_stats.latency_max_us / 1e3, k1_sim_stats.alarms);
+  }
+  printf("device rx           : frames %u, filtered %u of %u, not dropped %u, queue overflow %u\n",
+         rx.frames, rx.filtered, k1_sim_stats.overheard, k1_sim_stats.answered, rx.queue_overflow);
+  printf("device tx           : sent %u, busy %u, not armed %u, rejected %u\n", tx.sent, tx.busy, tx.not_armed, tx.rejected);
+  printf("pult capture        : frames %u, bad %u, glitches %u of %u, out of spec %u\n",
+         cap.frames, cap.bad_frames, cap.glitches, k1_sim_stats.glitches, cap.out_of_spec);
+  printf("host time per poll  : %.2f us\n", host_s * 1e6 / k1_sim_stats.polls);
+  return ((k1_sim_stats.lost == 0U) && (k1_sim_stats.bad == 0U) && (k1_sim_stats.answered == 0U) &&
+          (rx.filtered == k1_sim_stats.overheard)) ? 0 : 1;
+}
@@ -0,0 +1,34 @@
+/// *****************************************************************************
+/// @file           : crc-unit-model.h
+/// @brief          : model of the STM32F1 CRC unit for the host test of crc32
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// crc32.c of the test is built with this header forced in: the accesses to
+/// the data register go to the model, which calculates like the unit.
+
+#ifndef TEST_CRC_UNIT_MODEL_H_
+#define TEST_CRC_UNIT_MODEL_H_
+
+#include <stdint.h>
+
+/// Write the data register: the word is added to the CRC, MSB first
+/// @param word word
+void crc_unit_model_write(uint32_t word);
+
+/// Read the data register
+/// @return CRC value
+uint32_t crc_unit_model_read(void);
+
+/// Reset the data register to 0xFFFFFFFF
+void crc_unit_model_reset(void);
+
+#define CRC32_UNIT_WRITE(word)  crc_unit_model_write(word)
+#define CRC32_UNIT_READ()       crc_unit_model_read()
+#define CRC32_UNIT_RESET()      crc_unit_model_reset()
+
+#endif // #ifndef TEST_CRC_UNIT_MODEL_H_
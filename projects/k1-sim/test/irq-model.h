@@ -0,0 +1,26 @@
+/// *****************************************************************************
+/// @file           : irq-model.h
+/// @brief          : interrupt mask of the host tests
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// Modules which mask the interrupts by PRIMASK are built for the tests with
+/// this header forced in: the test runs in one thread, the mask does nothing.
+
+#ifndef TEST_IRQ_MODEL_H_
+#define TEST_IRQ_MODEL_H_
+
+#include "main.h"
+
+#undef __get_PRIMASK
+#undef __set_PRIMASK
+#undef __disable_irq
+#define __get_PRIMASK()         0U
+#define __set_PRIMASK(primask)  ((void)(primask))
+#define __disable_irq()         do {} while(0)
+
+#endif // #ifndef TEST_IRQ_MODEL_H_
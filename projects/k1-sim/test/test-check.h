@@ -0,0 +1,37 @@
+/// *****************************************************************************
+/// @file           : test-check.h
+/// @brief          : checks of the host tests
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// A failed check prints its place and goes on, the test prints its result
+/// by TEST_RESULT and returns 1 if any check has failed.
+
+#ifndef TEST_TEST_CHECK_H_
+#define TEST_TEST_CHECK_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+/// number of the failed checks, one per test program
+static uint32_t test_failed = 0;
+
+#define TEST_CHECK(cond)                                                      \
+  do                                                                          \
+  {                                                                           \
+    if(!(cond))                                                               \
+    {                                                                         \
+      printf("%s:%d: %s\n", __FILE__, __LINE__, #cond);                       \
+      ++test_failed;                                                          \
+    }                                                                         \
+  } while(0)
+
+#define TEST_RESULT(name)                                                     \
+  (printf("%-20s: %s\n", (name), (test_failed == 0U) ? "ok" : "FAILED"),      \
+   (test_failed == 0U) ? 0 : 1)
+
+#endif // #ifndef TEST_TEST_CHECK_H_
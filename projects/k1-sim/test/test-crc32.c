@@ -0,0 +1,155 @@
+/// *****************************************************************************
+/// @file           : test-crc32.c
+/// @brief          : host test of the shared CRC-32 service
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// The path through the CRC unit (crc-unit-model.h) and the software path
+/// are checked against known CRC-32/MPEG-2 values and against a bitwise
+/// reference, the stream which loses the unit to a second stream goes on
+/// in software and must give the same value.
+
+#include <string.h>
+#include "crc32.h"
+#include "crc-unit-model.h"
+#include "test-check.h"
+
+// CRC-32/MPEG-2 check value of "123456789"
+#define TEST_CRC32_CHECK        0x0376E6E7U
+// CRC of one zero word, the value of the STM32 CRC unit
+#define TEST_CRC32_ZERO_WORD    0xC704DD7BU
+
+static uint32_t test_crc_unit_dr = CRC32_INIT_VAL;
+
+/// @name test_crc_ref
+/// @brief The function calculates CRC-32/MPEG-2 bit by bit.
+/// @param crc CRC value to continue
+/// @param bytes bytes
+/// @param len number of bytes
+/// @return CRC value
+static uint32_t test_crc_ref(uint32_t crc, const uint8_t * bytes, uint32_t len)
+{
+  for(uint32_t i = 0; i < len; ++i)
+  {
+    crc ^= (uint32_t)bytes[i] << 24;
+    for(uint8_t b = 0; b < 8U; ++b)
+      crc = (crc & 0x80000000U) ? ((crc << 1) ^ 0x04C11DB7U) : (crc << 1);
+  }
+  return crc;
+}
+
+void crc_unit_model_write(uint32_t word)
+{
+  uint8_t bytes[4] = {(uint8_t)(word >> 24), (uint8_t)(word >> 16), (uint8_t)(word >> 8), (uint8_t)word};
+  test_crc_unit_dr = test_crc_ref(test_crc_unit_dr, bytes, 4);
+}
+
+uint32_t crc_unit_model_read(void)
+{
+  return test_crc_unit_dr;
+}
+
+void crc_unit_model_reset(void)
+{
+  test_crc_unit_dr = CRC32_INIT_VAL;
+}
+
+/// @name test_vectors
+/// @brief The function checks the known values and every length of bytes.
+static void test_vectors(void)
+{
+  static const uint8_t check[] = "123456789";
+  uint32_t zero = 0;
+  uint8_t bytes[37];
+  for(uint8_t i = 0; i < sizeof(bytes); ++i)
+    bytes[i] = (uint8_t)(i * 37U + 11U);
+
+  TEST_CHECK(crc32_calc_bytes(check, 9) == TEST_CRC32_CHECK);
+  TEST_CHECK(crc32_calc_words(&zero, 1) == TEST_CRC32_ZERO_WORD);
+  TEST_CHECK(crc32_calc_bytes(check, 0) == CRC32_INIT_VAL);
+  // words are taken MSB first, as bytes packed big-endian
+  uint32_t words[2] = {0x31323334U, 0x35363738U};
+  TEST_CHECK(crc32_calc_words(words, 2) == test_crc_ref(CRC32_INIT_VAL, check, 8));
+  // unaligned tails
+  for(uint32_t len = 0; len <= sizeof(bytes); ++len)
+    TEST_CHECK(crc32_calc_bytes(bytes, len) == test_crc_ref(CRC32_INIT_VAL, bytes, len));
+  // the stream is fed in pieces of every size
+  for(uint32_t piece = 1; piece <= 5U; ++piece)
+  {
+    crc32_ctx_type ctx;
+    crc32_begin(&ctx);
+    for(uint32_t pos = 0; pos < sizeof(bytes); pos += piece)
+      crc32_update_bytes(&ctx, &bytes[pos], (pos + piece <= sizeof(bytes)) ? piece : (uint32_t)(sizeof(bytes) - pos));
+    TEST_CHECK(crc32_end(&ctx) == test_crc_ref(CRC32_INIT_VAL, bytes, sizeof(bytes)));
+  }
+  // words after an unaligned start
+  crc32_ctx_type ctx;
+  uint8_t joined[9];
+  memcpy(joined, check, 1);
+  memcpy(&joined[1], "12345678", 8);
+  crc32_begin(&ctx);
+  crc32_update_bytes(&ctx, check, 1);
+  crc32_update_words(&ctx, words, 2);
+  TEST_CHECK(crc32_end(&ctx) == test_crc_ref(CRC32_INIT_VAL, joined, 9));
+}
+
+/// @name test_takeover
+/// @brief The function runs two streams: the second takes the unit, the
+/// @brief first continues in software.
+/// @param unit 1 - the service has the CRC unit
+static void test_takeover(uint8_t unit)
+{
+  static const uint8_t check[] = "123456789";
+  crc32_ctx_type first;
+  crc32_ctx_type second;
+  crc32_ctx_type isr;
+
+  crc32_begin(&first);
+  crc32_update_bytes(&first, check, 5);
+  TEST_CHECK(first.in_unit == unit);
+  crc32_begin(&second);
+  TEST_CHECK(first.in_unit == 0U);
+  TEST_CHECK(second.in_unit == unit);
+  crc32_update_bytes(&second, check, 6);
+  crc32_update_bytes(&first, &check[5], 4);
+  // a software stream of an interrupt does not disturb the unit
+  crc32_begin_sw(&isr);
+  crc32_update_bytes(&isr, check, 9);
+  TEST_CHECK(crc32_end(&isr) == TEST_CRC32_CHECK);
+  TEST_CHECK(second.in_unit == unit);
+  crc32_update_bytes(&second, &check[6], 3);
+  TEST_CHECK(crc32_end(&second) == TEST_CRC32_CHECK);
+  TEST_CHECK(crc32_end(&first) == TEST_CRC32_CHECK);
+
+  // the first stream ends after losing the unit at a word boundary
+  uint32_t words[3] = {0x31323334U, 0x35363738U, 0x39000000U};
+  crc32_begin(&first);
+  crc32_update_words(&first, words, 1);
+  crc32_begin(&second);
+  crc32_update_words(&first, &words[1], 1);
+  crc32_update_bytes(&first, &check[8], 1);
+  crc32_update_bytes(&second, check, 9);
+  TEST_CHECK(crc32_end(&first) == TEST_CRC32_CHECK);
+  TEST_CHECK(crc32_end(&second) == TEST_CRC32_CHECK);
+}
+
+int main(void)
+{
+  static CRC_HandleTypeDef test_crc;
+
+  // software path
+  crc32_init(0);
+  test_vectors();
+  test_takeover(0U);
+
+  // CRC unit path
+  crc32_init(&test_crc);
+  test_vectors();
+  test_takeover(1U);
+
+  return TEST_RESULT("test-crc32");
+}
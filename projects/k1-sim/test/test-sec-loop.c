@@ -0,0 +1,300 @@
+/// *****************************************************************************
+/// @file           : test-sec-loop.c
+/// @brief          : host test of the classification of security loops
+/// *****************************************************************************
+/// created 17.10.2026
+/// @attention
+/// Copyright 2026 (c) KART CONTROLS
+/// All rights reserved.
+/// *****************************************************************************
+
+/// sec_loop_classify and sec_loop_update are checked on the zones of an
+/// address label loop: the bounds of every zone, the scaling by the supply,
+/// the hysteresis up and down, the integration time and the hold of the
+/// states without supply. The fast path runs on the stubs of the filter and
+/// the ADC below: the watchdog interrupt which reads a stale sample keeps it
+/// armed.
+
+#include "sec-loop.h"
+#include "adc-filter.h"
+#include "time-base.h"
+#include "test-check.h"
+
+// supply of the test, Q15 of ADC full scale
+#define TEST_VIN_Q15            20000U
+#define TEST_HYST_Q15           655U
+#define TEST_INTEGRATION_MS     300U
+// time of the value in ms
+#define TEST_US(ms)             ((uint64_t)(ms) * 1000U)
+
+static const sec_loop_zone_type test_zones[] =
+{
+  {3277,  SEC_LOOP_SHORT},
+  {11468, SEC_LOOP_ALARM},
+  {19660, SEC_LOOP_NORM},
+  {26214, SEC_LOOP_TAMPER},
+  {0,     SEC_LOOP_OPEN}
+};
+
+static const sec_loop_config_type test_config =
+{
+  .zones = test_zones,
+  .zones_num = sizeof(test_zones) / sizeof(test_zones[0]),
+  .hyst_q15 = TEST_HYST_Q15,
+  .integration_ms = TEST_INTEGRATION_MS,
+  .fast = 0
+};
+
+// filter, ADC and time seen by sec-loop
+static int16_t test_q15[ADC_SCAN_CHANNELS];
+static uint32_t test_outputs = 0;
+static uint16_t test_latest = 0;
+static uint64_t test_now_us = 0;
+static ADC_TypeDef test_adc_regs;
+static ADC_HandleTypeDef test_adc = {.Instance = &test_adc_regs};
+static TIM_TypeDef test_tim_regs;
+static TIM_HandleTypeDef test_tim = {.Instance = &test_tim_regs};
+
+static uint32_t test_events = 0;
+static sec_loop_state_type test_event_state = SEC_LOOP_UNDEFINED;
+static uint64_t test_event_edge_us = 0;
+
+// stubs of the filter, the ADC and the time base
+uint64_t time_base_ms(void) { return test_now_us / 1000U; }
+uint64_t time_base_us(void) { return test_now_us; }
+uint16_t adc_filter_get_gain(void) { return ADC_FILTER_GAIN_ONE; }
+int16_t adc_filter_get_q15(adc_scan_channel_type ch) { return test_q15[ch]; }
+uint32_t adc_filter_get_outputs(adc_scan_channel_type ch) { (void)ch; return test_outputs; }
+uint32_t adc_scan_get_adc_channel(adc_scan_channel_type ch) { return ch; }
+uint16_t adc_scan_get_latest(adc_scan_channel_type ch) { (void)ch; return test_latest; }
+
+/// @name test_handler
+/// @brief The function stores the last state change.
+static void test_handler(uint8_t input, sec_loop_state_type state, uint64_t edge_us)
+{
+  (void)input;
+  ++test_events;
+  test_event_state = state;
+  test_event_edge_us = edge_us;
+}
+
+/// @name test_level
+/// @brief The function gives the loop voltage of the ratio to the supply.
+/// @param ratio_q15 ratio to the supply
+/// @param vin_q15 supply voltage
+/// @return loop voltage, Q15 of ADC full scale
+static uint16_t test_level(uint32_t ratio_q15, uint16_t vin_q15)
+{
+  return (uint16_t)((ratio_q15 * vin_q15) >> 15);
+}
+
+/// @name test_classify
+/// @brief The function checks the bounds of the zones, the supply scaling
+/// @brief and the hysteresis.
+static void test_classify(void)
+{
+  const uint8_t none = SEC_LOOP_ZONES_MAX;
+  const uint8_t last = test_config.zones_num - 1U;
+
+  // zone edges, no current zone
+  for(uint8_t z = 0; z < last; ++z)
+  {
+    uint16_t bound = test_level(test_zones[z].upper_q15, TEST_VIN_Q15);
+    TEST_CHECK(sec_loop_classify(&test_config, bound - 1U, TEST_VIN_Q15, none) == z);
+    TEST_CHECK(sec_loop_classify(&test_config, bound + 1U, TEST_VIN_Q15, none) == z + 1U);
+  }
+  TEST_CHECK(sec_loop_classify(&test_config, 0, TEST_VIN_Q15, none) == 0U);
+  TEST_CHECK(sec_loop_classify(&test_config, 0x7FFFU, TEST_VIN_Q15, none) == last);
+
+  // the same loop voltage is another zone at another supply
+  TEST_CHECK(sec_loop_classify(&test_config, 7000, TEST_VIN_Q15, none) == 2U);
+  TEST_CHECK(sec_loop_classify(&test_config, 7000, TEST_VIN_Q15 / 2U, none) == 3U);
+  TEST_CHECK(sec_loop_classify(&test_config, 7000, TEST_VIN_Q15 * 3U / 2U, none) == 1U);
+  // the bounds scale with the supply
+  for(uint16_t vin = SEC_LOOP_VIN_MIN_Q15; vin < 0x7FFFU; vin += 0x0800U)
+  {
+    uint16_t bound = test_level(test_zones[2].upper_q15, vin);
+    TEST_CHECK(sec_loop_classify(&test_config, bound - 1U, vin, none) == 2U);
+    TEST_CHECK(sec_loop_classify(&test_config, bound + 1U, vin, none) == 3U);
+  }
+
+  // hysteresis up: NORM is kept up to its bound plus the hysteresis
+  uint16_t up = test_level(test_zones[2].upper_q15, TEST_VIN_Q15);
+  uint16_t up_hyst = test_level(test_zones[2].upper_q15 + TEST_HYST_Q15, TEST_VIN_Q15);
+  TEST_CHECK(sec_loop_classify(&test_config, up + 1U, TEST_VIN_Q15, 2) == 2U);
+  TEST_CHECK(sec_loop_classify(&test_config, up_hyst - 1U, TEST_VIN_Q15, 2) == 2U);
+  TEST_CHECK(sec_loop_classify(&test_config, up_hyst + 1U, TEST_VIN_Q15, 2) == 3U);
+  // hysteresis down: NORM is kept down to the bound below minus the hysteresis
+  uint16_t down = test_level(test_zones[1].upper_q15, TEST_VIN_Q15);
+  uint16_t down_hyst = test_level(test_zones[1].upper_q15 - TEST_HYST_Q15, TEST_VIN_Q15);
+  TEST_CHECK(sec_loop_classify(&test_config, down - 1U, TEST_VIN_Q15, 2) == 2U);
+  TEST_CHECK(sec_loop_classify(&test_config, down_hyst + 1U, TEST_VIN_Q15, 2) == 2U);
+  TEST_CHECK(sec_loop_classify(&test_config, down_hyst - 1U, TEST_VIN_Q15, 2) == 1U);
+  // the hysteresis of the lower zone holds it back from NORM as well
+  TEST_CHECK(sec_loop_classify(&test_config, down + 1U, TEST_VIN_Q15, 1) == 1U);
+  TEST_CHECK(sec_loop_classify(&test_config, test_level(test_zones[1].upper_q15 + TEST_HYST_Q15, TEST_VIN_Q15) + 1U,
+                               TEST_VIN_Q15, 1) == 2U);
+  // a jump over several zones is taken at once
+  TEST_CHECK(sec_loop_classify(&test_config, 0x7FFFU, TEST_VIN_Q15, 0) == last);
+  TEST_CHECK(sec_loop_classify(&test_config, 0, TEST_VIN_Q15, last) == 0U);
+}
+
+/// @name test_update
+/// @brief The function checks the integration time and the hold without
+/// @brief supply.
+static void test_update(void)
+{
+  sec_loop_config_type config[3] = {test_config, test_config, test_config};
+  config[1].integration_ms = 0;
+  config[2].zones = 0;
+  uint16_t norm = test_level(15000, TEST_VIN_Q15);
+  uint16_t alarm = test_level(8000, TEST_VIN_Q15);
+
+  TEST_CHECK(sec_loop_init(config, SEC_LOOP_INPUTS + 1U) == SEC_LOOP_ERR);
+  TEST_CHECK(sec_loop_init(config, 3) == SEC_LOOP_OK);
+  sec_loop_set_handler(test_handler);
+
+  // the first state waits for the integration time too
+  sec_loop_update(0, norm, TEST_VIN_Q15, TEST_US(1000));
+  sec_loop_update(0, norm, TEST_VIN_Q15, TEST_US(1000 + TEST_INTEGRATION_MS) - 1U);
+  TEST_CHECK(sec_loop_get_state(0) == SEC_LOOP_UNDEFINED);
+  TEST_CHECK(test_events == 0U);
+  sec_loop_update(0, norm, TEST_VIN_Q15, TEST_US(1000 + TEST_INTEGRATION_MS));
+  TEST_CHECK(sec_loop_get_state(0) == SEC_LOOP_NORM);
+  TEST_CHECK(test_events == 1U);
+  TEST_CHECK(test_event_edge_us == TEST_US(1000));
+
+  // a short alarm is filtered out, a return to NORM restarts the integration
+  sec_loop_update(0, alarm, TEST_VIN_Q15, TEST_US(2000));
+  sec_loop_update(0, norm, TEST_VIN_Q15, TEST_US(2100));
+  sec_loop_update(0, alarm, TEST_VIN_Q15, TEST_US(2200));
+  sec_loop_update(0, alarm, TEST_VIN_Q15, TEST_US(2000 + TEST_INTEGRATION_MS));
+  TEST_CHECK(sec_loop_get_state(0) == SEC_LOOP_NORM);
+  sec_loop_update(0, alarm, TEST_VIN_Q15, TEST_US(2200 + TEST_INTEGRATION_MS - 1U));
+  TEST_CHECK(sec_loop_get_state(0) == SEC_LOOP_NORM);
+  sec_loop_update(0, alarm, TEST_VIN_Q15, TEST_US(2200 + TEST_INTEGRATION_MS));
+  TEST_CHECK(sec_loop_get_state(0) == SEC_LOOP_ALARM);
+  TEST_CHECK(test_event_state == SEC_LOOP_ALARM);
+  TEST_CHECK(test_events == 2U);
+  // the edge is the time the voltage has come into the zone
+  TEST_CHECK(sec_loop_get_edge_us(0) == TEST_US(2200));
+
+  // no supply holds the state and stops the integration
+  sec_loop_update(0, norm, TEST_VIN_Q15, TEST_US(3000));
+  sec_loop_update(0, norm, SEC_LOOP_VIN_MIN_Q15 - 1U, TEST_US(3100));
+  sec_loop_update(0, norm, TEST_VIN_Q15, TEST_US(3200));
+  sec_loop_update(0, norm, TEST_VIN_Q15, TEST_US(3000 + TEST_INTEGRATION_MS));
+  TEST_CHECK(sec_loop_get_state(0) == SEC_LOOP_ALARM);
+  sec_loop_update(0, norm, TEST_VIN_Q15, TEST_US(3200 + TEST_INTEGRATION_MS));
+  TEST_CHECK(sec_loop_get_state(0) == SEC_LOOP_NORM);
+  TEST_CHECK(test_events == 3U);
+
+  // no integration time, the zero voltage of a lost supply is not a short circuit
+  sec_loop_update(1, 0x7FFFU, TEST_VIN_Q15, TEST_US(0));
+  TEST_CHECK(sec_loop_get_state(1) == SEC_LOOP_OPEN);
+  sec_loop_update(1, 0, SEC_LOOP_VIN_MIN_Q15 - 1U, TEST_US(10));
+  TEST_CHECK(sec_loop_get_state(1) == SEC_LOOP_OPEN);
+  sec_loop_update(1, 0, 0, TEST_US(20));
+  TEST_CHECK(sec_loop_get_state(1) == SEC_LOOP_OPEN);
+  TEST_CHECK(test_events == 4U);
+
+  // inputs which are off or out of range stay undefined
+  sec_loop_update(2, norm, TEST_VIN_Q15, TEST_US(0));
+  TEST_CHECK(sec_loop_get_state(2) == SEC_LOOP_UNDEFINED);
+  sec_loop_update(SEC_LOOP_INPUTS, norm, TEST_VIN_Q15, TEST_US(0));
+  TEST_CHECK(sec_loop_get_state(SEC_LOOP_INPUTS) == SEC_LOOP_UNDEFINED);
+  TEST_CHECK(test_events == 4U);
+}
+
+/// @name test_filtered
+/// @brief The function hands new filtered values to sec-loop.
+/// @param line_q15 loop voltage of the input 0
+static void test_filtered(uint16_t line_q15)
+{
+  test_q15[ADC_SCAN_V_IN] = TEST_VIN_Q15;
+  test_q15[ADC_SCAN_SECURITY1] = (int16_t)line_q15;
+  ++test_outputs;
+  sec_loop_isr();
+}
+
+/// @name test_awd_armed
+/// @brief The function tells the watchdog interrupt is enabled.
+/// @return 1 - armed
+static uint8_t test_awd_armed(void)
+{
+  return READ_BIT(test_adc_regs.CR1, ADC_CR1_AWDIE) ? 1U : 0U;
+}
+
+/// @name test_fast
+/// @brief The function checks the alarm by the analog watchdog and the
+/// @brief wakeups which read a sample DMA has not written yet.
+static void test_fast(void)
+{
+  sec_loop_config_type config = test_config;
+  config.integration_ms = 0;
+  config.fast = 1U;
+  // samples are 12 bit, the gain is one
+  uint16_t norm = test_level(15000, TEST_VIN_Q15);
+  uint16_t alarm = test_level(8000, TEST_VIN_Q15);
+  sec_loop_fast_stats_type stats;
+
+  TEST_CHECK(sec_loop_fast_init(0, &test_tim) == SEC_LOOP_ERR);
+  TEST_CHECK(sec_loop_fast_init(&test_adc, &test_tim) == SEC_LOOP_OK);
+  TEST_CHECK(sec_loop_init(&config, 1) == SEC_LOOP_OK);
+  test_filtered(norm);
+  TEST_CHECK(sec_loop_get_state(0) == SEC_LOOP_NORM);
+  TEST_CHECK(test_awd_armed());
+  // the window of NORM with the hysteresis on the input, 12 bit samples
+  uint32_t vin = TEST_VIN_Q15 >> 3;
+  TEST_CHECK(test_adc_regs.LTR == (((uint32_t)(test_zones[1].upper_q15 - TEST_HYST_Q15) * vin) >> 15));
+  TEST_CHECK(test_adc_regs.HTR == (((uint32_t)(test_zones[2].upper_q15 + TEST_HYST_Q15) * vin) >> 15));
+  TEST_CHECK((test_adc_regs.CR1 & ADC_CR1_AWDCH) == ADC_SCAN_SECURITY1);
+  TEST_CHECK((test_adc_regs.CR1 & (ADC_CR1_AWDSGL | ADC_CR1_AWDEN)) == (ADC_CR1_AWDSGL | ADC_CR1_AWDEN));
+
+  // the stale sample is inside the window, the watchdog stays armed
+  test_latest = norm >> 3;
+  sec_loop_awd_isr();
+  TEST_CHECK(test_awd_armed());
+  // the next scans read the alarm
+  test_latest = alarm >> 3;
+  test_now_us += ADC_SCAN_PERIOD_US;
+  sec_loop_awd_isr();
+  TEST_CHECK(sec_loop_get_state(0) == SEC_LOOP_NORM);
+  TEST_CHECK(test_awd_armed());
+  test_now_us += ADC_SCAN_PERIOD_US;
+  sec_loop_awd_isr();
+  TEST_CHECK(sec_loop_get_state(0) == SEC_LOOP_ALARM);
+  TEST_CHECK(!test_awd_armed());
+  sec_loop_get_fast_stats(&stats);
+  TEST_CHECK(stats.wakeups == 3U);
+  TEST_CHECK(stats.inconclusive == 1U);
+  TEST_CHECK(stats.alarms == 1U);
+
+  // two reads inside the window in a row disarm it till the next value
+  test_filtered(norm);
+  test_now_us += 10U * ADC_SCAN_PERIOD_US;
+  test_filtered(norm);
+  TEST_CHECK(sec_loop_get_state(0) == SEC_LOOP_NORM);
+  TEST_CHECK(test_awd_armed());
+  test_latest = norm >> 3;
+  sec_loop_awd_isr();
+  TEST_CHECK(test_awd_armed());
+  test_now_us += ADC_SCAN_PERIOD_US;
+  sec_loop_awd_isr();
+  TEST_CHECK(!test_awd_armed());
+  sec_loop_get_fast_stats(&stats);
+  TEST_CHECK(stats.inconclusive == 2U);
+  TEST_CHECK(stats.alarms == 1U);
+  // the next filtered value arms it again
+  test_filtered(norm);
+  TEST_CHECK(test_awd_armed());
+}
+
+int main(void)
+{
+  test_classify();
+  test_update();
+  test_fast();
+
+  return TEST_RESULT("test-sec-loop");
+}
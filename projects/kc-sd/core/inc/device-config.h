@@ -14,12 +14,32 @@
 /// number of K1 addresses in the device
 #define K1_NUM_OF_ITEMS 1U
 
-/// main short cycle period in ms
-#define MAIN_SHORT_CYCLE_PERIOD_MS  10U
+/// period of K1 frames processing in ms
+#define MAIN_K1_PERIOD_MS           1U
+/// no POLL of the item during this time is the loss of link, ms
+#define MAIN_K1_LINK_TIMEOUT_MS     5000U
+/// period of settings task: every call checks the flash-async operation of
+/// the record and queues the next one (page erase, record, page header), the
+/// flash interrupt runs them, so a record takes a few periods
+#define MAIN_SETTINGS_PERIOD_MS     10U
+/// period of ADC calibration by Vrefint and temperature in ms
+#define MAIN_ADC_CAL_PERIOD_MS      1000U
+/// gestures of the address button, ms
+#define MAIN_GESTURE_HOLD_MS        2000U // a push of this time is a hold
+#define MAIN_GESTURE_GAP_MS         400U  // pause between clicks of a sequence
+#define MAIN_GESTURE_REPEAT_MS      1000U // repeat of the hold
+/// size of the queue of security loop events, a power of 2
+#define MAIN_SEC_LOOP_EVENTS_SIZE   16U
+
+/// supply of the K1 loop on v_in_mon, mV
+#define MAIN_SUPPLY_FULL_SCALE_MV   36300U  // 3.3 V at the divider 1:11
+#define MAIN_SUPPLY_SAG_MV          18000U  // load shedding below it
+#define MAIN_SUPPLY_LOW_MV          15000U
+#define MAIN_SUPPLY_HYST_MV         1000U
 
 /// address for device settings in MCU Flash
-#define FLASH_SETS_MAIN_ADDR 0x0800F800 // page 62, 1KB
-#define FLASH_SETS_COPY_ADDR 0x0800FC00 // page 63, 1KB
+#define FLASH_SETS_MAIN_ADDR 0x0800F800 // page 62, 1KB, settings log
+#define FLASH_SETS_COPY_ADDR 0x0800FC00 // page 63, 1KB, settings log
 
 /// MCU pin-out for the device
 
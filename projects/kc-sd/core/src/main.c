@@ -11,13 +11,32 @@
 
 #include "main.h"
 #include "adc.h"
+#include "adc-cal.h"
+#include "adc-filter.h"
+#include "adc-scan.h"
 #include "buttons.h"
+#include "crc.h"
+#include "crc32.h"
 #include "device-config.h"
+#include "dma.h"
+#include "event-queue.h"
+#include "flash-async.h"
+#include "gesture.h"
 #include "gpio.h"
 #include "i2c.h"
+#include "item-state.h"
 #include "k1-addr.h"
+#include "k1-capture.h"
+#include "k1-dup.h"
+#include "k1-frame.h"
+#include "k1-rx.h"
+#include "k1-tx.h"
+#include "scheduler.h"
+#include "sec-loop.h"
 #include "settings.h"
 #include "spi.h"
+#include "supply.h"
+#include "time-base.h"
 #include "tim.h"
 #include "usart.h"
 #include "wwdg.h"
@@ -25,64 +44,412 @@
 
 
 void SystemClock_Config(void);
+static void main_k1_task(void);
+static void main_buttons_task(void);
+static void main_settings_task(void);
+static void main_sec_loop_task(void);
+static void main_supply_task(void);
+static void main_adc_cal_task(void);
+static void main_adc_block_isr(const adc_scan_block_type * block);
+static void main_sec_loop_event_isr(uint8_t input, sec_loop_state_type state, uint64_t edge_us);
+static void main_supply_event_isr(supply_state_type state);
+static void main_buttons_edge_isr(void);
+static void main_k1_dup_confirmed(uint8_t item);
 
-int main(void)
+// tasks of the device
+enum
+{
+  MAIN_TASK_K1,
+  MAIN_TASK_BUTTONS,
+  MAIN_TASK_SETTINGS,
+  MAIN_TASK_SEC_LOOP,
+  MAIN_TASK_SUPPLY,
+  MAIN_TASK_ADC_CAL,
+  MAIN_TASKS_AMOUNT
+};
+
+static const sched_task_type MAIN_TASKS[MAIN_TASKS_AMOUNT] =
+{
+  //                         function               period                      deadline                    priority
+  [MAIN_TASK_K1] =          {main_k1_task,          MAIN_K1_PERIOD_MS,          MAIN_K1_PERIOD_MS,          0U},
+  [MAIN_TASK_BUTTONS] =     {main_buttons_task,     0U,                         0U,                         1U},
+  [MAIN_TASK_SETTINGS] =    {main_settings_task,    MAIN_SETTINGS_PERIOD_MS,    0U,                         2U},
+  [MAIN_TASK_SEC_LOOP] =    {main_sec_loop_task,    0U,                         MAIN_K1_PERIOD_MS,          0U},
+  [MAIN_TASK_SUPPLY] =      {main_supply_task,      0U,                         MAIN_K1_PERIOD_MS,          1U},
+  [MAIN_TASK_ADC_CAL] =     {main_adc_cal_task,     MAIN_ADC_CAL_PERIOD_MS,     0U,                         3U},
+};
+
+// last POLL of the items
+static uint64_t main_k1_poll_ms[K1_NUM_OF_ITEMS];
+static uint8_t main_k1_link_lost[K1_NUM_OF_ITEMS];
+// started replies of the items when the reply was armed
+static uint32_t main_k1_started[K1_NUM_OF_ITEMS];
+// supply health: the minimum since the last started reply and the value in
+// the armed reply
+static uint8_t main_k1_supply[K1_NUM_OF_ITEMS];
+static uint8_t main_k1_supply_armed[K1_NUM_OF_ITEMS];
+// address set mode of the commissioning, it is not a state of the items on
+// K1: ITEM_STATE_SERVICE is the dust of the detector
+static uint8_t main_addr_mode = 0;
+
+// state changes of the security loops, from ADC interrupts to the task
+static event_queue_event_type main_sec_loop_events_buf[MAIN_SEC_LOOP_EVENTS_SIZE];
+static event_queue_type main_sec_loop_events;
+
+// filters of analog inputs, scans come every ADC_SCAN_PERIOD_US
+static const adc_filter_config_type MAIN_ADC_FILTERS[ADC_SCAN_CHANNELS] =
+{
+  //                      osr_log2  iir_shift
+  [ADC_SCAN_V_IN] =      {6U,       2U},  // 16 ms
+  [ADC_SCAN_SECURITY1] = {7U,       2U},  // 32 ms
+  [ADC_SCAN_SECURITY2] = {7U,       2U},
+  [ADC_SCAN_SECURITY3] = {7U,       2U},
+  [ADC_SCAN_SECURITY4] = {7U,       2U},
+  [ADC_SCAN_SECURITY5] = {7U,       2U},
+  [ADC_SCAN_SECURITY6] = {7U,       2U},
+};
+
+// monitor of the K1 loop supply
+static const supply_config_type MAIN_SUPPLY =
 {
-  static uint32_t counter_short_cycle_ms = 0;
+  MAIN_SUPPLY_FULL_SCALE_MV, MAIN_SUPPLY_SAG_MV, MAIN_SUPPLY_LOW_MV, MAIN_SUPPLY_HYST_MV
+};
 
+// gestures of the address button for commissioning
+enum
+{
+  MAIN_GESTURE_TEST,          // double click: LED test on/off
+  MAIN_GESTURE_ADDR_DONE,     // triple click: leave address set mode
+  MAIN_GESTURE_ADDR,          // hold: address set mode, repeats step the address
+  MAIN_GESTURE_RESET          // click and hold: reset of the latched fire
+};
+
+static const gesture_type MAIN_GESTURES_ADDR[] =
+{
+  //  seq                                           repeat_ms               id
+  {{GESTURE_CLICK, GESTURE_CLICK},                  0U,                     MAIN_GESTURE_TEST},
+  {{GESTURE_CLICK, GESTURE_CLICK, GESTURE_CLICK},   0U,                     MAIN_GESTURE_ADDR_DONE},
+  {{GESTURE_HOLD},                                  MAIN_GESTURE_REPEAT_MS, MAIN_GESTURE_ADDR},
+  {{GESTURE_CLICK, GESTURE_HOLD},                   0U,                     MAIN_GESTURE_RESET},
+};
+
+static const gesture_config_type MAIN_GESTURES[BUTTONS_AMOUNT] =
+{
+  //                    gestures            gestures_num                                             hold_ms               gap_ms
+  [BUTTON_FUNC_ADDR] = {MAIN_GESTURES_ADDR, sizeof(MAIN_GESTURES_ADDR) / sizeof(MAIN_GESTURES_ADDR[0]), MAIN_GESTURE_HOLD_MS, MAIN_GESTURE_GAP_MS},
+};
+
+// zones of the security loops, ratio of the loop to v_in_mon readings
+static const sec_loop_zone_type MAIN_SEC_LOOP_ZONES[] =
+{
+  //  upper_q15                 state
+  {(uint16_t)(0.10 * 32768),  SEC_LOOP_SHORT},
+  {(uint16_t)(0.35 * 32768),  SEC_LOOP_ALARM},
+  {(uint16_t)(0.60 * 32768),  SEC_LOOP_NORM},
+  {(uint16_t)(0.80 * 32768),  SEC_LOOP_TAMPER},
+  {0U,                        SEC_LOOP_OPEN},
+};
+#define MAIN_SEC_LOOP_ZONES_NUM   (sizeof(MAIN_SEC_LOOP_ZONES) / sizeof(MAIN_SEC_LOOP_ZONES[0]))
+#define MAIN_SEC_LOOP_HYST_Q15    ((uint16_t)(0.02 * 32768))
+
+// classifiers of the security loops of address labels
+static const sec_loop_config_type MAIN_SEC_LOOPS[SEC_LOOP_INPUTS] =
+{
+  //  zones                 zones_num                 hyst_q15                integration_ms  fast
+  {MAIN_SEC_LOOP_ZONES, MAIN_SEC_LOOP_ZONES_NUM, MAIN_SEC_LOOP_HYST_Q15, 300U,           1U},
+  {MAIN_SEC_LOOP_ZONES, MAIN_SEC_LOOP_ZONES_NUM, MAIN_SEC_LOOP_HYST_Q15, 300U,           1U},
+  {MAIN_SEC_LOOP_ZONES, MAIN_SEC_LOOP_ZONES_NUM, MAIN_SEC_LOOP_HYST_Q15, 300U,           1U},
+  {MAIN_SEC_LOOP_ZONES, MAIN_SEC_LOOP_ZONES_NUM, MAIN_SEC_LOOP_HYST_Q15, 300U,           1U},
+  {MAIN_SEC_LOOP_ZONES, MAIN_SEC_LOOP_ZONES_NUM, MAIN_SEC_LOOP_HYST_Q15, 300U,           1U},
+  {MAIN_SEC_LOOP_ZONES, MAIN_SEC_LOOP_ZONES_NUM, MAIN_SEC_LOOP_HYST_Q15, 300U,           1U},
+};
+
+int main(void)
+{
   HAL_Init();
   SystemClock_Config();
+  time_base_init();
   MX_GPIO_Init();
+  MX_DMA_Init();
   MX_ADC1_Init();
+  MX_CRC_Init();
   MX_I2C2_Init();
   MX_SPI1_Init();
   MX_TIM1_Init();
   MX_TIM2_Init();
+  MX_TIM3_Init();
   MX_TIM4_Init();
   MX_USART1_UART_Init();
   MX_USART2_UART_Init();
   MX_WWDG_Init();
   buttons_init();
+  buttons_set_edge_handler(main_buttons_edge_isr);
+  gesture_init(MAIN_GESTURES, BUTTONS_AMOUNT);
+  item_state_init();
+
+  // shared CRC unit for settings and K1 frames
+  crc32_init(&hcrc);
+
+  // background flash writes for settings
+  flash_async_init();
 
   // initialize settings
-  CRC_HandleTypeDef crc_unit = {CRC, HAL_UNLOCKED, HAL_CRC_STATE_RESET};
-  settings_init(&crc_unit);
+  settings_init();
 
   // initialize k1 addresses
   for(uint8_t i = 0; i < K1_NUM_OF_ITEMS; ++i)
   {
     k1_addr_set(settings_get_k1_address(i), i);
+    item_state_event(i, (k1_addr_get(i) != 0U) ? ITEM_EV_ADDR_SET : ITEM_EV_ADDR_NONE, time_base_us());
+    main_k1_poll_ms[i] = time_base_ms();
+    main_k1_supply[i] = UINT8_MAX;
   }
 
-  while (1)
+  // start K1 bus reception, frames for other devices are dropped in ISR,
+  // replies to POLL are started by TIM1 at the end of the request
+  k1_tx_init(&htim1);
+  k1_rx_set_filter(k1_frame_addr_match);
+  k1_rx_set_end_handler(k1_tx_request_end_isr);
+  k1_rx_init(&huart2);
+
+  // start K1 line pulse capture, symbols are decoded per frame
+  k1_cap_init(&htim4);
+
+  // echoes of the replies find duplicate addresses, the back-off is seeded
+  // by the UID of the MCU
+  k1_dup_init(HAL_GetUIDw0() ^ HAL_GetUIDw1() ^ HAL_GetUIDw2());
+  k1_dup_set_handler(main_k1_dup_confirmed);
+
+  // security loops are used by address labels only
+  uint8_t sec_loops = 0;
+  if(settings_get_device_type() == SETS_DEV_TYPE_AL2)
+    sec_loops = 2U;
+  else if(settings_get_device_type() == SETS_DEV_TYPE_AL6)
+    sec_loops = 6U;
+  event_queue_init(&main_sec_loop_events, main_sec_loop_events_buf, MAIN_SEC_LOOP_EVENTS_SIZE);
+  sec_loop_init(MAIN_SEC_LOOPS, sec_loops);
+  sec_loop_set_handler(main_sec_loop_event_isr);
+  // alarms of the loops are also caught by the analog watchdog of ADC1
+  sec_loop_fast_init(&hadc1, &htim3);
+
+  // the supply sag sheds the load
+  supply_init(&MAIN_SUPPLY);
+  supply_set_handler(main_supply_event_isr);
+
+  // self-calibration of ADC1, then start the scan of analog inputs, TIM3
+  // triggers ADC1, the blocks are filtered, the supply is checked and the
+  // loops are classified in DMA interrupt
+  adc_cal_init(&hadc1);
+  adc_filter_init(MAIN_ADC_FILTERS);
+  adc_scan_set_handler(main_adc_block_isr);
+  adc_scan_init(&hadc1, &htim3);
+
+  // run the tasks, the CPU sleeps between them
+  sched_init(MAIN_TASKS, MAIN_TASKS_AMOUNT);
+  sched_run();
+}
+
+/// K1 task: received frames and armed replies
+static void main_k1_task(void)
+{
+  // process received K1 frames
+  k1_rx_frame_type k1_raw;
+  while(k1_rx_frame_peek(&k1_raw))
   {
-    // short cycle
-    if(HAL_GetTick() >= counter_short_cycle_ms)
+    k1_frame_type k1_frame;
+    if(k1_frame_parse(&k1_raw, &k1_frame) == K1_FRAME_OK)
     {
-      // update counter
-      counter_short_cycle_ms = HAL_GetTick() + MAIN_SHORT_CYCLE_PERIOD_MS;
-      // update buttons
-      buttons_handler();
-      // process buttns clicks
-      // long push ADDR button - address change
-      if(buttons_get_long_push_flags() && (1U << BUTTON_FUNC_ADDR))
+      // POLL of the item keeps the link
+      uint8_t i = k1_addr_get_item(k1_frame.dst);
+      if((k1_frame.cmd == K1_FRAME_CMD_POLL) && (i < K1_NUM_OF_ITEMS))
       {
-        // TBD
+        k1_dup_poll(i);
+        main_k1_poll_ms[i] = time_base_ms();
+        if(main_k1_link_lost[i])
+        {
+          main_k1_link_lost[i] = 0;
+          item_state_event(i, ITEM_EV_LINK_OK, time_base_us());
+        }
       }
-      // short push ADDR button - test LEDs
-      if(buttons_get_short_push_flags() && (1U << BUTTON_FUNC_ADDR))
+      // TBD
+    }
+    k1_rx_frame_release();
+  }
+
+  // loss of link
+  for(uint8_t i = 0; i < K1_NUM_OF_ITEMS; ++i)
+  {
+    if(!main_k1_link_lost[i] && (time_base_elapsed_ms(main_k1_poll_ms[i]) > MAIN_K1_LINK_TIMEOUT_MS))
+    {
+      main_k1_link_lost[i] = 1U;
+      item_state_event(i, ITEM_EV_LINK_LOST, time_base_us());
+    }
+  }
+
+  // process frames captured on K1 line: echoes of our replies and replies
+  // of other devices
+  uint8_t k1_line[K1_CAP_FRAME_MAX_LEN];
+  uint8_t k1_line_len = k1_cap_frame_get(k1_line, sizeof(k1_line));
+  if(k1_line_len > 0U)
+    k1_dup_frame(k1_line, k1_line_len);
+  k1_dup_handler();
+
+  // keep replies to POLL armed with the state of the item, a new state
+  // re-arms the reply at once; the supply health is the minimum since the
+  // previous reply, a new minimum re-arms the reply too; the item keeps
+  // silent during the back-off of a collision
+  uint8_t supply = supply_get_health();
+  for(uint8_t i = 0; i < K1_NUM_OF_ITEMS; ++i)
+  {
+    // the state is published when its reply starts on the line, the next
+    // minimum of the supply starts too
+    uint64_t start_us;
+    uint32_t started = k1_tx_get_started(i, &start_us);
+    if(started != main_k1_started[i])
+    {
+      main_k1_started[i] = started;
+      item_state_published(i, start_us);
+      main_k1_supply[i] = UINT8_MAX;
+    }
+    if(supply < main_k1_supply[i])
+      main_k1_supply[i] = supply;
+    if(!k1_dup_may_reply(i))
+      continue;
+    if(!k1_tx_is_armed(i) || item_state_is_changed(i) || (main_k1_supply_armed[i] != main_k1_supply[i]))
+    {
+      main_k1_supply_armed[i] = main_k1_supply[i];
+      uint8_t state[3] = {(uint8_t)item_state_get(i), main_k1_supply[i], k1_dup_challenge()};
+      // a reply started before the arm carries the old state
+      if(k1_tx_arm(i, K1_FRAME_CMD_STATE, state, sizeof(state)) == K1_TX_OK)
       {
-        // TBD
+        item_state_armed(i);
+        main_k1_started[i] = k1_tx_get_started(i, 0);
       }
     }
-    // protection of freezing during 0 crossing for short cycle
-    if(HAL_GetTick() < MAIN_SHORT_CYCLE_PERIOD_MS)
+  }
+}
+
+/// buttons task: started by the edges of the buttons
+static void main_buttons_task(void)
+{
+  // update buttons, recognize gestures
+  buttons_handler();
+  event_queue_event_type event;
+  while(buttons_get_event(&event))
+    gesture_input(&event);
+  gesture_handler();
+
+  // again while a button is moving or a gesture is in progress
+  uint32_t next_ms = buttons_get_next_ms();
+  uint32_t gesture_ms = gesture_get_next_ms();
+  if((gesture_ms != 0U) && ((next_ms == 0U) || (gesture_ms < next_ms)))
+    next_ms = gesture_ms;
+  if(next_ms != 0U)
+    sched_start(MAIN_TASK_BUTTONS, next_ms);
+
+  // process gestures of ADDR button
+  while(gesture_get(&event))
+  {
+    if((event.arg & 0xFFU) != BUTTON_FUNC_ADDR)
+      continue;
+    if(event.type == MAIN_GESTURE_ADDR)
+    {
+      // the first report enters address set mode, the repeats in the mode
+      // step the address, address change TBD
+      if((event.arg >> 8) == 0U)
+        main_addr_mode = 1U;
+      continue;
+    }
+    if(event.type == MAIN_GESTURE_ADDR_DONE)
     {
-      counter_short_cycle_ms = 0;
+      main_addr_mode = 0;
+      continue;
     }
+    for(uint8_t i = 0; i < K1_NUM_OF_ITEMS; ++i)
+    {
+      if(event.type == MAIN_GESTURE_TEST)
+      {
+        // test LEDs TBD
+        item_state_event(i, (item_state_get(i) == ITEM_STATE_TEST) ? ITEM_EV_TEST_OFF : ITEM_EV_TEST_ON, event.time_us);
+      }
+      else if(event.type == MAIN_GESTURE_RESET)
+      {
+        item_state_event(i, ITEM_EV_RESET, event.time_us);
+      }
+    }
+  }
+}
+
+/// duplicate address of the item, from the K1 task
+static void main_k1_dup_confirmed(uint8_t item)
+{
+  item_state_event(item, ITEM_EV_DUPLICATE, time_base_us());
+}
+
+/// settings task: background write of committed settings
+static void main_settings_task(void)
+{
+  settings_handler();
+}
+
+/// security loop task: started by the state changes of the loops
+static void main_sec_loop_task(void)
+{
+  // input i drives item i, the changes come in order, faults of the loops TBD
+  event_queue_event_type event;
+  while(event_queue_get(&main_sec_loop_events, &event))
+  {
+    uint8_t i = (uint8_t)event.arg;
+    if(i >= K1_NUM_OF_ITEMS)
+      continue;
+    if(event.type == SEC_LOOP_ALARM)
+      item_state_event(i, ITEM_EV_FIRE, event.time_us);
+    else if(event.type == SEC_LOOP_NORM)
+      item_state_event(i, ITEM_EV_NORM, event.time_us);
   }
 }
 
+/// supply task: started by the state changes of the supply
+static void main_supply_task(void)
+{
+  // flash erase waits for the supply; LED and buzzer PWM, when they are
+  // added, must not start unless supply_get_state() is SUPPLY_NORM
+  flash_async_hold_erase((supply_get_state() == SUPPLY_NORM) ? 0U : 1U);
+}
+
+/// ADC calibration task: Vrefint and temperature
+static void main_adc_cal_task(void)
+{
+  adc_cal_start();
+}
+
+/// block of analog samples, from ADC DMA interrupt
+static void main_adc_block_isr(const adc_scan_block_type * block)
+{
+  adc_filter_block(block);
+  supply_block_isr(block);
+  sec_loop_isr();
+}
+
+/// state change of the supply, from ADC DMA interrupt
+static void main_supply_event_isr(supply_state_type state)
+{
+  sched_start(MAIN_TASK_SUPPLY, 0U);
+}
+
+/// edge of the buttons, from EXTI interrupt
+static void main_buttons_edge_isr(void)
+{
+  sched_start(MAIN_TASK_BUTTONS, 0U);
+}
+
+/// state change of the security loop, from ADC interrupts
+static void main_sec_loop_event_isr(uint8_t input, sec_loop_state_type state, uint64_t edge_us)
+{
+  event_queue_post(&main_sec_loop_events, (uint16_t)state, input, edge_us);
+  sched_start(MAIN_TASK_SEC_LOOP, 0U);
+}
+
 
 /// @brief System Clock Configuration
 /// @retval None